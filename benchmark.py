@@ -0,0 +1,60 @@
+import argparse
+import json
+import logging
+
+from smartHuePy.helpers.helpers import SetupHelper
+from smartHuePy.helpers import benchmark
+
+logging.basicConfig(level=logging.INFO)
+
+SUITES = {
+    "config": benchmark.bench_config,
+    "endpoints": benchmark.bench_endpoints,
+    "keepalive": benchmark.bench_keepalive,
+    "tls": benchmark.bench_tls,
+    "udp": benchmark.bench_udp,
+}
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='SmartHue Benchmark')
+    parser.add_argument('-d', '--devices', type=argparse.FileType('r'), required=True)
+    parser.add_argument('-s', '--suite', choices=sorted(SUITES.keys()), action='append')
+    parser.add_argument('-n', '--iterations', type=int, default=20)
+    parser.add_argument('-o', '--output', type=argparse.FileType('w'))
+    return parser.parse_args()
+
+
+def get_config(config):
+    config_load = json.loads(config.read())
+    config.close()
+    return config_load
+
+
+def main():
+    args = parse_args()
+    config = get_config(args.devices)
+    hostnames = config["devices"]["test"]
+    suites = args.suite or sorted(SUITES.keys())
+
+    setup = SetupHelper()
+    for name in hostnames:
+        setup.add(name)
+
+    results = []
+    for name in hostnames:
+        device = setup.get(name)
+        if not device.get_version():
+            logging.info("%s: device is not up" % device.hostname)
+            continue
+
+        for suite in suites:
+            results.append(SUITES[suite](device, args.iterations))
+
+    if args.output:
+        json.dump(results, args.output, indent=4)
+        args.output.close()
+
+
+if __name__ == "__main__":
+    main()
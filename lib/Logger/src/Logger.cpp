@@ -2,7 +2,14 @@
 #include "Arduino.h"
 
 Logger::Logger()
-    : m_hostname("")
+    : m_nodeSeverity(Logger::ERROR)
+    , m_threshold(Logger::DEBUG)
+    , m_hostname("")
+    , m_queueHead(0)
+    , m_queueLength(0)
+    , m_queueHighWater(0)
+    , m_dropped(0)
+    , m_queued(false)
 {
     // register default logger
     registerLogger([](const String& message) {
@@ -11,7 +18,14 @@ Logger::Logger()
 }
 
 Logger::Logger(const String& hostname)
-    : m_hostname(hostname)
+    : m_nodeSeverity(Logger::ERROR)
+    , m_threshold(Logger::DEBUG)
+    , m_hostname(hostname)
+    , m_queueHead(0)
+    , m_queueLength(0)
+    , m_queueHighWater(0)
+    , m_dropped(0)
+    , m_queued(false)
 {
     // register default logger
     registerLogger([](const String& message) {
@@ -22,6 +36,15 @@ Logger::Logger(const String& hostname)
 void Logger::registerLogger(void (*logger)(const String&), Severity severity)
 {
     m_loggerNodeList.add({ logger, severity });
+    if (m_nodeSeverity < severity) {
+        m_nodeSeverity = severity;
+    }
+}
+
+void Logger::resetDefaultLogger()
+{
+    m_loggerNodeList.clear();
+    m_nodeSeverity = Logger::ERROR;
 }
 
 void Logger::getLogTime(String& msg)
@@ -65,4 +88,58 @@ void Logger::pushLogToNodes(String& msg, const Severity& severity)
 
         loggerNode.logger(msg);
     }
-}
\ No newline at end of file
+}
+
+void Logger::pushLogToQueue(const String& msg, const Severity& severity)
+{
+#if LOGGER_QUEUE_SIZE > 0
+    if (m_queueLength == LOGGER_QUEUE_SIZE) {
+        m_dropped++;
+        return;
+    }
+
+    QueueEntry& entry = m_queue[(m_queueHead + m_queueLength) % LOGGER_QUEUE_SIZE];
+    entry.severity = severity;
+    strncpy(entry.message, msg.c_str(), sizeof(entry.message) - 1);
+    entry.message[sizeof(entry.message) - 1] = '\0';
+
+    m_queueLength++;
+    if (m_queueHighWater < m_queueLength) {
+        m_queueHighWater = m_queueLength;
+    }
+#else
+    String message = msg;
+    pushLogToNodes(message, severity);
+#endif
+}
+
+void Logger::setQueued(bool queued)
+{
+    if (!queued) {
+        flushQueue();
+    }
+    m_queued = queued && LOGGER_QUEUE_SIZE > 0;
+}
+
+size_t Logger::drainQueue(unsigned long budgetUs)
+{
+    size_t handled = 0;
+#if LOGGER_QUEUE_SIZE > 0
+    unsigned long timeNow = micros();
+    while (m_queueLength) {
+        QueueEntry& entry = m_queue[m_queueHead];
+        String message = entry.message;
+        Severity severity = entry.severity;
+        m_queueHead = (m_queueHead + 1) % LOGGER_QUEUE_SIZE;
+        m_queueLength--;
+
+        pushLogToNodes(message, severity);
+        handled++;
+
+        if (micros() - timeNow >= budgetUs) {
+            break;
+        }
+    }
+#endif
+    return handled;
+}
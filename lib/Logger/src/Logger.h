@@ -5,6 +5,73 @@
 #include <Arduino.h>
 #include <LinkedList.h>
 
+/**
+ * Compile-time minimum log level, everything more verbose is removed
+ * from the build by the LOGGER_* macros below.
+ * 0: ERROR, 1: WARN, 2: INFO, 3: DEBUG
+ *
+ * e.g. build_flags = -DLOGGER_MIN_LEVEL=2
+ */
+#ifndef LOGGER_MIN_LEVEL
+#define LOGGER_MIN_LEVEL 3
+#endif
+
+/**
+ * The message expression is only evaluated when at least one
+ * registered logger will consume it.
+ *
+ * ussage e.g.:
+ * LOGGER_INFO(logger, "[OTA] progress: " + String(progress));
+ */
+#define LOGGER_LOG(logger, message, severity) \
+    do {                                        \
+        if ((logger).accepts(severity)) {       \
+            (logger).log(message, severity);    \
+        }                                       \
+    } while (0)
+
+/**
+ * Optional ring buffer between log() and the registered loggers,
+ * the size is the max amount of queued lines (0 disables the queue).
+ *
+ * e.g. build_flags = -DLOGGER_QUEUE_SIZE=16
+ */
+#ifndef LOGGER_QUEUE_SIZE
+#define LOGGER_QUEUE_SIZE 0
+#endif
+
+#ifndef LOGGER_QUEUE_LINE_LENGTH
+#define LOGGER_QUEUE_LINE_LENGTH 128
+#endif
+
+#define LOGGER_NOP() \
+    do {             \
+    } while (0)
+
+#if LOGGER_MIN_LEVEL >= 0
+#define LOGGER_ERROR(logger, message) LOGGER_LOG(logger, message, Logger::ERROR)
+#else
+#define LOGGER_ERROR(logger, message) LOGGER_NOP()
+#endif
+
+#if LOGGER_MIN_LEVEL >= 1
+#define LOGGER_WARN(logger, message) LOGGER_LOG(logger, message, Logger::WARN)
+#else
+#define LOGGER_WARN(logger, message) LOGGER_NOP()
+#endif
+
+#if LOGGER_MIN_LEVEL >= 2
+#define LOGGER_INFO(logger, message) LOGGER_LOG(logger, message, Logger::INFO)
+#else
+#define LOGGER_INFO(logger, message) LOGGER_NOP()
+#endif
+
+#if LOGGER_MIN_LEVEL >= 3
+#define LOGGER_DEBUG(logger, message) LOGGER_LOG(logger, message, Logger::DEBUG)
+#else
+#define LOGGER_DEBUG(logger, message) LOGGER_NOP()
+#endif
+
 class Logger : public Print {
 public:
     enum class Severity {
@@ -24,11 +91,32 @@ public:
     Logger(const String& hostName);
 
     void registerLogger(void (*logger)(const String&), Severity severity = Logger::INFO);
-    void resetDefaultLogger() { m_loggerNodeList.clear(); }
+    void resetDefaultLogger();
+
+    /**
+     * Runtime threshold, messages more verbose than this are dropped
+     * before any formatting is done.
+     */
+    void setThreshold(const Severity severity) { m_threshold = severity; }
+    Severity getThreshold() const { return m_threshold; }
+
+    /**
+     * @return true if a message of this severity will reach at least one logger
+     */
+    bool accepts(const Severity severity) const
+    {
+        return (int)severity <= LOGGER_MIN_LEVEL
+            && severity <= m_threshold
+            && severity <= m_nodeSeverity;
+    }
 
     template <typename Printable>
     void log(const Printable message, const Severity severity = Logger::INFO)
     {
+        if (!accepts(severity)) {
+            return;
+        }
+
         String logTime;
         getLogTime(logTime);
 
@@ -36,9 +124,39 @@ public:
         getLogSeverity(logSeverity, severity);
 
         String logMessage = logTime + (m_hostname != "" ? " " + m_hostname : "") + " " + logSeverity + ": " + String(message);
-        pushLogToNodes(logMessage, severity);
+        if (m_queued) {
+            pushLogToQueue(logMessage, severity);
+        } else {
+            pushLogToNodes(logMessage, severity);
+        }
     }
 
+    /**
+     * Only append to the ring buffer in log(), the registered loggers are
+     * called from drainQueue(). Without a queue (LOGGER_QUEUE_SIZE 0)
+     * logging stays synchronous.
+     */
+    void setQueued(bool queued);
+    bool isQueued() const { return m_queued; }
+
+    /**
+     * Push queued lines to the registered loggers for at most budgetUs
+     * microseconds, at least one line is handled per call.
+     *
+     * @return the amount of handled lines
+     */
+    size_t drainQueue(unsigned long budgetUs);
+
+    /**
+     * Push all queued lines to the registered loggers, use this before
+     * a reboot or a blocking endless loop.
+     */
+    void flushQueue() { drainQueue(ULONG_MAX); }
+
+    uint32_t getDroppedCount() const { return m_dropped; }
+    size_t getQueueLength() const { return m_queueLength; }
+    size_t getQueueHighWater() const { return m_queueHighWater; }
+
     size_t write(uint8_t buffer) override {
         if (buffer == '\n') {
             log(m_writer);
@@ -53,6 +171,7 @@ private:
     void getLogTime(String& msg);
     void getLogSeverity(String& msg, const Severity& severity);
     void pushLogToNodes(String& msg, const Severity& severity);
+    void pushLogToQueue(const String& msg, const Severity& severity);
 
     struct LoggerNode {
         void (*logger)(const String&);
@@ -60,8 +179,24 @@ private:
     };
 
     LinkedList<LoggerNode> m_loggerNodeList;
+    Severity m_nodeSeverity; // most verbose severity of all registered loggers
+    Severity m_threshold;
     String m_hostname;
     String m_writer;
+
+    struct QueueEntry {
+        Severity severity;
+        char message[LOGGER_QUEUE_LINE_LENGTH];
+    };
+
+#if LOGGER_QUEUE_SIZE > 0
+    QueueEntry m_queue[LOGGER_QUEUE_SIZE];
+#endif
+    size_t m_queueHead;
+    size_t m_queueLength;
+    size_t m_queueHighWater;
+    uint32_t m_dropped;
+    bool m_queued;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include "Arduino.h"
+#include "NativeShim.h"
+#include <ctime>
+#include <random>
+#include <unistd.h>
+
+namespace native {
+
+Options options;
+
+static uint64_t s_virtualUs = 0;
+static uint8_t s_levels[17] = {};
+static uint8_t s_modes[17] = {};
+static uint32_t s_changes[17] = {};
+
+static uint64_t monotonicUs()
+{
+    static timespec start = [] {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return now;
+    }();
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+uint64_t nowUs()
+{
+    // every look at the virtual clock costs a microsecond, so a busy wait always ends
+    return options.virtualTime ? s_virtualUs++ : monotonicUs();
+}
+
+void advanceUs(uint64_t us)
+{
+    if (options.virtualTime) {
+        s_virtualUs += us;
+    } else if (us) {
+        usleep(us);
+    }
+}
+
+uint16_t hostPort(uint16_t port)
+{
+    return port && port < 1024 ? port + options.portOffset : port;
+}
+
+static void setLevel(uint8_t pin, uint8_t level)
+{
+    if (pin > 16 || s_levels[pin] == level) {
+        return;
+    }
+    s_levels[pin] = level;
+    s_changes[pin]++;
+    if (options.gpioTrace) {
+        fprintf(stderr, "[gpio] %10.3f pin %2u -> %u\n", nowUs() / 1000000.0, pin, level);
+    }
+}
+
+uint8_t gpioLevel(uint8_t pin)
+{
+    return pin <= 16 ? s_levels[pin] : 0;
+}
+
+uint32_t gpioChanges(uint8_t pin)
+{
+    return pin <= 16 ? s_changes[pin] : 0;
+}
+
+}
+
+GpioRegister GPO;
+
+GpioRegister& GpioRegister::operator=(uint32_t value)
+{
+    for (uint8_t pin = 0; pin < 16; pin++) {
+        if (native::s_modes[pin] == OUTPUT) {
+            native::setLevel(pin, (value >> pin) & 1);
+        }
+    }
+    return *this;
+}
+
+GpioRegister::operator uint32_t() const
+{
+    uint32_t value = 0;
+    for (uint8_t pin = 0; pin < 16; pin++) {
+        value |= (uint32_t)native::s_levels[pin] << pin;
+    }
+    return value;
+}
+
+unsigned long millis()
+{
+    return native::nowUs() / 1000;
+}
+
+unsigned long micros()
+{
+    return native::nowUs();
+}
+
+void delay(unsigned long ms)
+{
+    native::serviceTimers();
+    native::advanceUs((uint64_t)ms * 1000);
+    native::serviceTimers();
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    native::advanceUs(us);
+}
+
+void yield()
+{
+    native::serviceTimers();
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (pin <= 16) {
+        native::s_modes[pin] = mode;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    native::setLevel(pin, val ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin)
+{
+    return native::gpioLevel(pin);
+}
+
+static std::mt19937& generator()
+{
+    static std::mt19937 s_generator(std::random_device {}());
+    return s_generator;
+}
+
+long random(long max)
+{
+    return max > 0 ? generator()() % max : 0;
+}
+
+long random(long min, long max)
+{
+    return min < max ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed)
+{
+    generator().seed(seed);
+}
+
+static uint8_t s_cpuFreqMHz = SYS_CPU_80MHZ;
+
+bool system_update_cpu_freq(uint8_t freq)
+{
+    if (freq != SYS_CPU_80MHZ && freq != SYS_CPU_160MHZ) {
+        return false;
+    }
+    s_cpuFreqMHz = freq;
+    return true;
+}
+
+uint8_t EspClass::getCpuFreqMHz()
+{
+    return s_cpuFreqMHz;
+}
+
+uint32_t EspClass::getCycleCount()
+{
+    return (uint32_t)(native::nowUs() * s_cpuFreqMHz);
+}
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
@@ -0,0 +1,83 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+/**
+ * Host build of the Arduino core API, see NativeShim.h for the
+ * simulator options.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "IPAddress.h"
+#include "Print.h"
+#include "Stream.h"
+#include "WString.h"
+#include "pgmspace.h"
+
+using std::isnan;
+using std::max;
+using std::min;
+
+typedef uint8_t byte;
+typedef bool boolean;
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x00
+#define INPUT_PULLUP 0x02
+#define OUTPUT 0x01
+
+#define LED_BUILTIN 2
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+inline bool isHexadecimalDigit(int c)
+{
+    return isxdigit(c) != 0;
+}
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+/**
+ * GPIO 0..15 output register, writes are captured like digitalWrite().
+ */
+class GpioRegister {
+public:
+    GpioRegister& operator=(uint32_t value);
+    operator uint32_t() const;
+};
+extern GpioRegister GPO;
+
+enum { SYS_CPU_80MHZ = 80, SYS_CPU_160MHZ = 160 };
+bool system_update_cpu_freq(uint8_t freq);
+
+#include "Esp.h"
+#include "HardwareSerial.h"
+
+void setup();
+void loop();
+
+#endif
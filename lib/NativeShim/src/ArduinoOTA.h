@@ -0,0 +1,75 @@
+#ifndef ArduinoOTA_h
+#define ArduinoOTA_h
+
+#include "Arduino.h"
+#include <functional>
+
+#define U_FLASH 0
+#define U_FS 100
+
+typedef enum {
+    OTA_AUTH_ERROR,
+    OTA_BEGIN_ERROR,
+    OTA_CONNECT_ERROR,
+    OTA_RECEIVE_ERROR,
+    OTA_END_ERROR
+} ota_error_t;
+
+/**
+ * OTA needs a flash to write to, the native build accepts the setup
+ * and never starts an update.
+ */
+class ArduinoOTAClass {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+    typedef std::function<void(ota_error_t)> THandlerFunction_Error;
+    typedef std::function<void(unsigned int, unsigned int)> THandlerFunction_Progress;
+
+    void setHostname(const char* hostname)
+    {
+        (void)hostname;
+    }
+    void setPassword(const char* password)
+    {
+        (void)password;
+    }
+    void setPort(uint16_t port)
+    {
+        (void)port;
+    }
+    void onStart(THandlerFunction fn)
+    {
+        m_onStart = fn;
+    }
+    void onEnd(THandlerFunction fn)
+    {
+        m_onEnd = fn;
+    }
+    void onError(THandlerFunction_Error fn)
+    {
+        m_onError = fn;
+    }
+    void onProgress(THandlerFunction_Progress fn)
+    {
+        m_onProgress = fn;
+    }
+    void begin(bool useMDNS = true)
+    {
+        (void)useMDNS;
+    }
+    void handle() { }
+    int getCommand() const
+    {
+        return U_FLASH;
+    }
+
+private:
+    THandlerFunction m_onStart;
+    THandlerFunction m_onEnd;
+    THandlerFunction_Error m_onError;
+    THandlerFunction_Progress m_onProgress;
+};
+
+extern ArduinoOTAClass ArduinoOTA;
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef DNSServer_h
+#define DNSServer_h
+
+#include "ESP8266WiFi.h"
+
+enum class DNSReplyCode {
+    NoError = 0,
+    FormError = 1,
+    ServerFailure = 2,
+    NonExistentDomain = 3,
+    NotImplemented = 4,
+    Refused = 5
+};
+
+/**
+ * Captive portal DNS: every A query is answered with the configured ip.
+ * The port is mapped with native::hostPort(), 53 listens on 8053.
+ */
+class DNSServer {
+public:
+    void setErrorReplyCode(const DNSReplyCode& replyCode)
+    {
+        m_errorReplyCode = replyCode;
+    }
+    void setTTL(const uint32_t ttl)
+    {
+        m_ttl = ttl;
+    }
+    bool start(const uint16_t port, const String& domainName, const IPAddress& resolvedIP);
+    void stop()
+    {
+        m_udp.stop();
+    }
+    void processNextRequest();
+
+private:
+    WiFiUDP m_udp;
+    String m_domainName;
+    IPAddress m_resolvedIP;
+    DNSReplyCode m_errorReplyCode = DNSReplyCode::NonExistentDomain;
+    uint32_t m_ttl = 60;
+};
+
+#endif
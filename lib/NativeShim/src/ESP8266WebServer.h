@@ -0,0 +1,41 @@
+#ifndef ESP8266WebServer_h
+#define ESP8266WebServer_h
+
+#include <cstddef>
+#include <cstdint>
+
+enum HTTPMethod {
+    HTTP_ANY,
+    HTTP_GET,
+    HTTP_HEAD,
+    HTTP_POST,
+    HTTP_PUT,
+    HTTP_PATCH,
+    HTTP_DELETE,
+    HTTP_OPTIONS
+};
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+
+#define HTTP_MAX_DATA_WAIT 5000
+#define HTTP_MAX_REQUEST_SIZE 16384
+
+#define HTTP_RAW_BUFLEN 1460
+
+enum HTTPRawStatus {
+    RAW_START,
+    RAW_WRITE,
+    RAW_END,
+    RAW_ABORTED
+};
+
+struct HTTPRaw {
+    HTTPRawStatus status;
+    size_t totalSize; // received so far
+    size_t currentSize; // in buf
+    uint8_t buf[HTTP_RAW_BUFLEN];
+    void* data;
+};
+
+#endif
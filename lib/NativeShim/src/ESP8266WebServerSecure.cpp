@@ -0,0 +1,391 @@
+#include "ESP8266WebServerSecure.h"
+#include <algorithm>
+#include <cctype>
+#include <memory>
+
+namespace BearSSL {
+
+static bool equalsIgnoreCase(const std::string& a, const char* b)
+{
+    return strcasecmp(a.c_str(), b) == 0;
+}
+
+static std::string base64Encode(const std::string& text)
+{
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    uint32_t bits = 0;
+    int count = 0;
+    for (unsigned char c : text) {
+        bits = bits << 8 | c;
+        count += 8;
+        while (count >= 6) {
+            count -= 6;
+            encoded += table[(bits >> count) & 0x3f];
+        }
+    }
+    if (count) {
+        encoded += table[(bits << (6 - count)) & 0x3f];
+    }
+    while (encoded.size() % 4) {
+        encoded += '=';
+    }
+    return encoded;
+}
+
+void ESP8266WebServerSecure::handleClient()
+{
+    if (!m_client.connected()) {
+        m_client = m_server.accept();
+        m_buffer.clear();
+        if (!m_client.connected()) {
+            return;
+        }
+        m_lastDataMs = millis();
+    }
+
+    char chunk[1024];
+    int length;
+    while ((length = m_client.read((uint8_t*)chunk, sizeof(chunk))) > 0) {
+        m_buffer.append(chunk, length);
+        m_lastDataMs = millis();
+    }
+
+    size_t headEnd = m_buffer.find("\r\n\r\n");
+    if (headEnd == std::string::npos) {
+        if (m_buffer.size() > HTTP_MAX_REQUEST_SIZE || (!m_buffer.empty() && millis() - m_lastDataMs > HTTP_MAX_DATA_WAIT)) {
+            m_client.stop(); // incomplete request
+        }
+        return;
+    }
+
+    std::string head = m_buffer.substr(0, headEnd);
+    size_t bodyLength = 0;
+    for (size_t line = head.find("\r\n"); line != std::string::npos; line = head.find("\r\n", line + 2)) {
+        size_t colon = head.find(':', line + 2);
+        if (colon != std::string::npos && equalsIgnoreCase(head.substr(line + 2, colon - line - 2), "Content-Length")) {
+            bodyLength = strtoul(head.c_str() + colon + 1, nullptr, 10);
+        }
+    }
+    if (bodyLength > HTTP_MAX_REQUEST_SIZE) {
+        m_client.stop();
+        return;
+    }
+    if (m_buffer.size() < headEnd + 4 + bodyLength) {
+        if (millis() - m_lastDataMs > HTTP_MAX_DATA_WAIT) {
+            m_client.stop(); // incomplete body
+        }
+        return;
+    }
+
+    bool valid = parseRequest(head, m_buffer.data() + headEnd + 4, bodyLength);
+    m_buffer.erase(0, headEnd + 4 + bodyLength);
+    if (!valid) {
+        m_client.stop();
+        return;
+    }
+
+    handleRequest();
+    if (!m_keepAlive || !m_http11) {
+        m_client = WiFiClientSecure(); // the handler may still hold a copy
+        m_buffer.clear();
+    }
+}
+
+bool ESP8266WebServerSecure::parseRequest(const std::string& head, const char* body, size_t bodyLength)
+{
+    m_args.clear();
+    m_responseHeaders.clear();
+    m_host = "";
+    for (Pair& header : m_headers) {
+        header.value = "";
+    }
+    m_contentLength = CONTENT_LENGTH_NOT_SET;
+    m_chunked = false;
+
+    size_t lineEnd = head.find("\r\n");
+    std::string requestLine = head.substr(0, lineEnd);
+    size_t methodEnd = requestLine.find(' ');
+    size_t urlEnd = requestLine.rfind(' ');
+    if (methodEnd == std::string::npos || urlEnd <= methodEnd) {
+        return false;
+    }
+
+    std::string method = requestLine.substr(0, methodEnd);
+    static const char* const methods[] = { "", "GET", "HEAD", "POST", "PUT", "PATCH", "DELETE", "OPTIONS" };
+    m_method = HTTP_ANY;
+    for (size_t i = 1; i < sizeof(methods) / sizeof(methods[0]); i++) {
+        if (method == methods[i]) {
+            m_method = (HTTPMethod)i;
+        }
+    }
+    m_http11 = requestLine.compare(urlEnd + 1, std::string::npos, "HTTP/1.1") == 0;
+
+    std::string url = requestLine.substr(methodEnd + 1, urlEnd - methodEnd - 1);
+    size_t query = url.find('?');
+    m_uri = urlDecode(url.substr(0, query).c_str());
+    if (query != std::string::npos) {
+        parseArguments(url.substr(query + 1).c_str());
+    }
+
+    bool form = false; // multipart, the only body the raw hook doesn't get
+    bool encoded = false;
+    while (lineEnd != std::string::npos) {
+        size_t next = head.find("\r\n", lineEnd + 2);
+        std::string line = head.substr(lineEnd + 2, next == std::string::npos ? std::string::npos : next - lineEnd - 2);
+        lineEnd = next;
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string name = line.substr(0, colon);
+        size_t valueStart = line.find_first_not_of(' ', colon + 1);
+        String value = valueStart == std::string::npos ? "" : line.substr(valueStart).c_str();
+
+        if (equalsIgnoreCase(name, "Host")) {
+            m_host = value;
+        } else if (equalsIgnoreCase(name, "Content-Type")) {
+            form = value.startsWith("multipart/");
+            encoded = value.startsWith("application/x-www-form-urlencoded");
+        }
+        for (Pair& header : m_headers) {
+            if (equalsIgnoreCase(name, header.key.c_str())) {
+                header.value = value;
+            }
+        }
+    }
+
+    // like the core: a handler that takes the raw body gets it in chunks, there's no "plain" argument then
+    m_currentHandler = nullptr;
+    for (auto* handler : m_handlers) {
+        if (handler->canHandle(m_method, m_uri)) {
+            m_currentHandler = handler;
+            break;
+        }
+    }
+    if (!form && m_currentHandler && m_currentHandler->canRaw(m_uri)) {
+        std::unique_ptr<HTTPRaw> raw(new HTTPRaw());
+        raw->status = RAW_START;
+        m_currentHandler->raw(*this, m_uri, *raw);
+        raw->status = RAW_WRITE;
+        while (raw->totalSize < bodyLength) {
+            raw->currentSize = std::min(bodyLength - raw->totalSize, (size_t)HTTP_RAW_BUFLEN);
+            memcpy(raw->buf, body + raw->totalSize, raw->currentSize);
+            raw->totalSize += raw->currentSize;
+            m_currentHandler->raw(*this, m_uri, *raw);
+        }
+        raw->status = RAW_END;
+        m_currentHandler->raw(*this, m_uri, *raw);
+        return true;
+    }
+
+    String plain(body, bodyLength);
+    if (encoded) {
+        parseArguments(plain);
+    }
+    if (bodyLength && !form) { // the shim doesn't parse multipart
+        m_args.push_back({ "plain", plain });
+    }
+    return true;
+}
+
+void ESP8266WebServerSecure::handleRequest()
+{
+    if (m_currentHandler && m_currentHandler->handle(*this, m_method, m_uri)) {
+        return;
+    }
+    for (const Route& route : m_routes) {
+        if (route.uri == m_uri && (route.method == HTTP_ANY || route.method == m_method)) {
+            route.handler();
+            return;
+        }
+    }
+    if (m_notFound) {
+        m_notFound();
+        return;
+    }
+    send(404, "text/plain", "Not found: " + m_uri);
+}
+
+void ESP8266WebServerSecure::parseArguments(const String& data)
+{
+    int start = 0;
+    while (start < (int)data.length()) {
+        int end = data.indexOf('&', start);
+        if (end < 0) {
+            end = data.length();
+        }
+        String pair = data.substring(start, end);
+        int equal = pair.indexOf('=');
+        if (pair.length()) {
+            m_args.push_back({ urlDecode(equal < 0 ? pair : pair.substring(0, equal)), equal < 0 ? String() : urlDecode(pair.substring(equal + 1)) });
+        }
+        start = end + 1;
+    }
+}
+
+String ESP8266WebServerSecure::urlDecode(const String& text)
+{
+    String decoded;
+    for (unsigned int i = 0; i < text.length(); i++) {
+        char c = text[i];
+        if (c == '+') {
+            c = ' ';
+        } else if (c == '%' && i + 2 < text.length() && isxdigit((unsigned char)text[i + 1]) && isxdigit((unsigned char)text[i + 2])) {
+            char hex[3] = { text[i + 1], text[i + 2], 0 };
+            c = (char)strtol(hex, nullptr, 16);
+            i += 2;
+        }
+        decoded += c;
+    }
+    return decoded;
+}
+
+String ESP8266WebServerSecure::arg(const String& name) const
+{
+    for (const Pair& arg : m_args) {
+        if (arg.key == name) {
+            return arg.value;
+        }
+    }
+    return String();
+}
+
+bool ESP8266WebServerSecure::hasArg(const String& name) const
+{
+    for (const Pair& arg : m_args) {
+        if (arg.key == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ESP8266WebServerSecure::collectHeaders(const char* headerKeys[], const size_t headerKeysCount)
+{
+    m_headers.clear();
+    m_headers.push_back({ "Authorization", "" }); // always collected, like the core
+    for (size_t i = 0; i < headerKeysCount; i++) {
+        m_headers.push_back({ headerKeys[i], "" });
+    }
+}
+
+String ESP8266WebServerSecure::header(const String& name) const
+{
+    for (const Pair& header : m_headers) {
+        if (header.key.equalsIgnoreCase(name)) {
+            return header.value;
+        }
+    }
+    return String();
+}
+
+bool ESP8266WebServerSecure::hasHeader(const String& name) const
+{
+    return header(name).length() > 0;
+}
+
+bool ESP8266WebServerSecure::authenticate(const char* user, const char* pass)
+{
+    String authorization = header("Authorization");
+    if (!authorization.startsWith("Basic ")) {
+        return false;
+    }
+    std::string expected = base64Encode(std::string(user) + ":" + pass);
+    return authorization.substring(6) == expected.c_str();
+}
+
+void ESP8266WebServerSecure::sendHeader(const String& name, const String& value, bool first)
+{
+    Pair header = { name, value };
+    if (first) {
+        m_responseHeaders.insert(m_responseHeaders.begin(), header);
+    } else {
+        m_responseHeaders.push_back(header);
+    }
+}
+
+void ESP8266WebServerSecure::send(int code, const char* contentType, const String& content)
+{
+    String head = "HTTP/1.";
+    head += m_http11 ? "1 " : "0 ";
+    head += String(code) + " " + responseCodeToString(code) + "\r\n";
+    head += "Content-Type: " + String(contentType ? contentType : "text/html") + "\r\n";
+
+    m_chunked = false;
+    if (m_contentLength == CONTENT_LENGTH_UNKNOWN) {
+        if (m_http11) {
+            m_chunked = true;
+            head += "Transfer-Encoding: chunked\r\n";
+        }
+    } else {
+        size_t length = m_contentLength == CONTENT_LENGTH_NOT_SET ? content.length() : m_contentLength;
+        head += "Content-Length: " + String((unsigned long)length) + "\r\n";
+    }
+    for (const Pair& header : m_responseHeaders) {
+        head += header.key + ": " + header.value + "\r\n";
+    }
+    head += m_keepAlive && m_http11 ? "Connection: keep-alive\r\n" : "Connection: close\r\n";
+    head += "\r\n";
+
+    m_responseHeaders.clear();
+    m_contentLength = CONTENT_LENGTH_NOT_SET;
+    m_client.write((const uint8_t*)head.c_str(), head.length());
+    if (content.length()) {
+        sendContent(content);
+    }
+}
+
+void ESP8266WebServerSecure::sendContent(const char* content, size_t size)
+{
+    if (!m_chunked) {
+        m_client.write((const uint8_t*)content, size);
+        return;
+    }
+    char header[16];
+    snprintf(header, sizeof(header), "%zx\r\n", size);
+    m_client.write((const uint8_t*)header, strlen(header));
+    m_client.write((const uint8_t*)content, size);
+    m_client.write((const uint8_t*)"\r\n", 2);
+    if (!size) {
+        m_chunked = false; // last chunk
+    }
+}
+
+void ESP8266WebServerSecure::requestAuthentication()
+{
+    sendHeader("WWW-Authenticate", "Basic realm=\"Login Required\"");
+    send(401, "text/html", "401 Unauthorized");
+}
+
+const char* ESP8266WebServerSecure::responseCodeToString(int code)
+{
+    switch (code) {
+    case 200:
+        return "OK";
+    case 204:
+        return "No Content";
+    case 304:
+        return "Not Modified";
+    case 400:
+        return "Bad Request";
+    case 401:
+        return "Unauthorized";
+    case 404:
+        return "Not Found";
+    case 405:
+        return "Method Not Allowed";
+    case 413:
+        return "Payload Too Large";
+    case 415:
+        return "Unsupported Media Type";
+    case 500:
+        return "Internal Server Error";
+    case 503:
+        return "Service Unavailable";
+    default:
+        return "";
+    }
+}
+
+}
@@ -0,0 +1,286 @@
+#ifndef ESP8266WebServerSecure_h
+#define ESP8266WebServerSecure_h
+
+#include "ESP8266WebServer.h"
+#include "ESP8266WiFi.h"
+#include <bearssl/bearssl.h>
+#include <functional>
+#include <vector>
+
+namespace BearSSL {
+class WiFiServerSecure;
+class ESP8266WebServerSecure;
+}
+
+namespace esp8266webserver {
+
+/**
+ * Subset of the core's RequestHandler: routing and the raw body hook,
+ * the native server only knows the secure server type.
+ */
+template <typename ServerType>
+class RequestHandler {
+    using WebServerType = BearSSL::ESP8266WebServerSecure;
+
+public:
+    virtual ~RequestHandler() { }
+    virtual bool canHandle(HTTPMethod method, const String& uri)
+    {
+        (void)method;
+        (void)uri;
+        return false;
+    }
+    virtual bool canRaw(const String& uri)
+    {
+        (void)uri;
+        return false;
+    }
+    virtual bool handle(WebServerType& server, HTTPMethod requestMethod, const String& requestUri)
+    {
+        (void)server;
+        (void)requestMethod;
+        (void)requestUri;
+        return false;
+    }
+    virtual void raw(WebServerType& server, const String& requestUri, HTTPRaw& raw)
+    {
+        (void)server;
+        (void)requestUri;
+        (void)raw;
+    }
+};
+
+}
+
+namespace BearSSL {
+
+class X509List {
+public:
+    explicit X509List(const char* pem)
+    {
+        (void)pem;
+    }
+};
+
+class PrivateKey {
+public:
+    explicit PrivateKey(const char* pem)
+    {
+        (void)pem;
+    }
+};
+
+class ServerSessions {
+public:
+    explicit ServerSessions(uint32_t size)
+        : m_size(size)
+    {
+    }
+    uint32_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    uint32_t m_size;
+};
+
+/**
+ * The native build has no TLS, a secure client is a plain TCP client.
+ */
+class WiFiClientSecure : public WiFiClient {
+public:
+    WiFiClientSecure() { }
+    WiFiClientSecure(const WiFiClient& client)
+        : WiFiClient(client)
+    {
+    }
+};
+
+class WiFiServerSecure : public WiFiServer {
+public:
+    explicit WiFiServerSecure(uint16_t port)
+        : WiFiServer(port)
+    {
+    }
+
+    void setECCert(const X509List* chain, unsigned certIssuerKeyType, const PrivateKey* key)
+    {
+        (void)chain;
+        (void)certIssuerKeyType;
+        (void)key;
+    }
+    void setRSACert(const X509List* chain, const PrivateKey* key)
+    {
+        (void)chain;
+        (void)key;
+    }
+    void setCache(ServerSessions* cache)
+    {
+        (void)cache;
+    }
+
+    WiFiClientSecure accept()
+    {
+        return WiFiServer::accept();
+    }
+};
+
+/**
+ * Plain HTTP/1.1 stand-in for the TLS webserver, with the request and
+ * response API of ESP8266WebServer that the firmware uses.
+ *
+ * Like the core, only one connection is handled at a time and a kept
+ * alive connection holds off the next one. A handler that takes over
+ * the client (event stream) keeps it open after keepAlive(false), the
+ * server only drops its own reference.
+ */
+class ESP8266WebServerSecure {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+
+    explicit ESP8266WebServerSecure(uint16_t port)
+        : m_server(port)
+    {
+        collectHeaders(nullptr, 0);
+    }
+
+    void begin()
+    {
+        m_server.begin();
+    }
+    void close()
+    {
+        m_client.stop();
+        m_server.close();
+    }
+    void stop()
+    {
+        close();
+    }
+
+    WiFiServerSecure& getServer()
+    {
+        return m_server;
+    }
+    WiFiClientSecure& client()
+    {
+        return m_client;
+    }
+
+    void on(const String& uri, HTTPMethod method, THandlerFunction handler)
+    {
+        m_routes.push_back({ uri, method, handler });
+    }
+    void on(const String& uri, THandlerFunction handler)
+    {
+        on(uri, HTTP_ANY, handler);
+    }
+    void addHandler(esp8266webserver::RequestHandler<WiFiServerSecure>* handler)
+    {
+        m_handlers.push_back(handler);
+    }
+    void onNotFound(THandlerFunction handler)
+    {
+        m_notFound = handler;
+    }
+
+    void handleClient();
+
+    // request
+    const String& uri() const
+    {
+        return m_uri;
+    }
+    HTTPMethod method() const
+    {
+        return m_method;
+    }
+    String arg(const String& name) const;
+    bool hasArg(const String& name) const;
+    int args() const
+    {
+        return m_args.size();
+    }
+    String arg(int index) const
+    {
+        return index < args() ? m_args[index].value : String();
+    }
+    String argName(int index) const
+    {
+        return index < args() ? m_args[index].key : String();
+    }
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+    String header(const String& name) const;
+    bool hasHeader(const String& name) const;
+    const String& hostHeader() const
+    {
+        return m_host;
+    }
+    bool authenticate(const char* user, const char* pass);
+
+    // response
+    void keepAlive(bool keepAlive)
+    {
+        m_keepAlive = keepAlive;
+    }
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(size_t contentLength)
+    {
+        m_contentLength = contentLength;
+    }
+    void send(int code, const char* contentType = nullptr, const String& content = String());
+    void send(int code, const String& contentType, const String& content)
+    {
+        send(code, contentType.c_str(), content);
+    }
+    void sendContent(const String& content)
+    {
+        sendContent(content.c_str(), content.length());
+    }
+    void sendContent(const char* content, size_t size);
+    void requestAuthentication();
+
+private:
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction handler;
+    };
+    struct Pair {
+        String key;
+        String value;
+    };
+
+    bool parseRequest(const std::string& head, const char* body, size_t bodyLength);
+    void handleRequest();
+    void parseArguments(const String& data);
+    static String urlDecode(const String& text);
+    static const char* responseCodeToString(int code);
+
+    WiFiServerSecure m_server;
+    WiFiClientSecure m_client;
+    std::vector<Route> m_routes;
+    std::vector<esp8266webserver::RequestHandler<WiFiServerSecure>*> m_handlers;
+    esp8266webserver::RequestHandler<WiFiServerSecure>* m_currentHandler = nullptr;
+    THandlerFunction m_notFound;
+
+    std::string m_buffer; // received, not handled yet
+    unsigned long m_lastDataMs = 0;
+
+    HTTPMethod m_method = HTTP_ANY;
+    String m_uri;
+    String m_host;
+    bool m_http11 = true;
+    std::vector<Pair> m_args;
+    std::vector<Pair> m_headers; // collected headers, value empty if not received
+    std::vector<Pair> m_responseHeaders;
+
+    bool m_keepAlive = false;
+    size_t m_contentLength = CONTENT_LENGTH_NOT_SET;
+    bool m_chunked = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,432 @@
+#include "ESP8266WiFi.h"
+#include "NativeShim.h"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <linux/sockios.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define WIFI_CLIENT_MSS 1460
+#define WIFI_UDP_MAX_PACKET 1472
+
+ESP8266WiFiClass WiFi;
+
+static sockaddr_in toSockaddr(IPAddress ip, uint16_t port)
+{
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = (uint32_t)ip; // both in network byte order
+    address.sin_port = htons(port);
+    return address;
+}
+
+static bool resolve(const char* host, IPAddress& ip)
+{
+    if (ip.fromString(host)) {
+        return true;
+    }
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &result) != 0 || !result) {
+        return false;
+    }
+    ip = IPAddress((uint32_t)((sockaddr_in*)result->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(result);
+    return true;
+}
+
+static bool waitFor(int fd, short events, unsigned long timeoutMs)
+{
+    pollfd request = { fd, events, 0 };
+    return poll(&request, 1, timeoutMs) > 0 && (request.revents & events);
+}
+
+// WiFiClient
+
+WiFiClient::Socket::~Socket()
+{
+    close();
+}
+
+void WiFiClient::Socket::close()
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+WiFiClient::WiFiClient(int fd)
+    : m_socket(std::make_shared<Socket>(fd))
+{
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+    stop();
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    m_socket = std::make_shared<Socket>(fd);
+
+    sockaddr_in address = toSockaddr(ip, port);
+    if (::connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (errno != EINPROGRESS || !waitFor(fd, POLLOUT, m_timeout)
+            || getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error) {
+            stop();
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int WiFiClient::connect(const char* host, uint16_t port)
+{
+    IPAddress ip;
+    return resolve(host, ip) ? connect(ip, port) : 0;
+}
+
+size_t WiFiClient::write(const uint8_t* buffer, size_t size)
+{
+    size_t written = 0;
+    unsigned long start = millis();
+    while (written < size && fd() >= 0) {
+        ssize_t n = send(fd(), buffer + written, size - written, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            written += n;
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            break;
+        }
+        unsigned long elapsed = millis() - start;
+        if (elapsed >= m_timeout || !waitFor(fd(), POLLOUT, m_timeout - elapsed)) {
+            break;
+        }
+    }
+    return written;
+}
+
+int WiFiClient::availableForWrite()
+{
+    // like the core: room for a segment or nothing
+    return fd() >= 0 && waitFor(fd(), POLLOUT, 0) ? WIFI_CLIENT_MSS : 0;
+}
+
+int WiFiClient::available()
+{
+    int length = 0;
+    if (fd() < 0 || ioctl(fd(), FIONREAD, &length) != 0) {
+        return 0;
+    }
+    return length;
+}
+
+int WiFiClient::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+int WiFiClient::read(uint8_t* buffer, size_t size)
+{
+    if (fd() < 0) {
+        return -1;
+    }
+    ssize_t n = recv(fd(), buffer, size, MSG_DONTWAIT);
+    return n > 0 ? n : (n == 0 || errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1);
+}
+
+int WiFiClient::peek()
+{
+    uint8_t c;
+    return fd() >= 0 && recv(fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT) == 1 ? c : -1;
+}
+
+void WiFiClient::flush()
+{
+    unsigned long start = millis();
+    int pending = 0;
+    while (fd() >= 0 && ioctl(fd(), SIOCOUTQ, &pending) == 0 && pending > 0 && millis() - start < m_timeout) {
+        usleep(1000);
+    }
+}
+
+void WiFiClient::stop()
+{
+    if (m_socket) {
+        m_socket->close();
+    }
+    m_socket.reset();
+}
+
+uint8_t WiFiClient::connected()
+{
+    if (fd() < 0) {
+        return 0;
+    }
+    uint8_t c;
+    ssize_t n = recv(fd(), &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n > 0 || (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+}
+
+IPAddress WiFiClient::remoteIP()
+{
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    return fd() >= 0 && getpeername(fd(), (sockaddr*)&address, &length) == 0 ? IPAddress((uint32_t)address.sin_addr.s_addr) : IPAddress();
+}
+
+uint16_t WiFiClient::remotePort()
+{
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    return fd() >= 0 && getpeername(fd(), (sockaddr*)&address, &length) == 0 ? ntohs(address.sin_port) : 0;
+}
+
+IPAddress WiFiClient::localIP()
+{
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    return fd() >= 0 && getsockname(fd(), (sockaddr*)&address, &length) == 0 ? IPAddress((uint32_t)address.sin_addr.s_addr) : IPAddress();
+}
+
+uint16_t WiFiClient::localPort()
+{
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    return fd() >= 0 && getsockname(fd(), (sockaddr*)&address, &length) == 0 ? ntohs(address.sin_port) : 0;
+}
+
+void WiFiClient::setNoDelay(bool noDelay)
+{
+    int value = noDelay;
+    if (fd() >= 0) {
+        setsockopt(fd(), IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+    }
+}
+
+// WiFiServer
+
+void WiFiServer::begin()
+{
+    close();
+    m_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) {
+        return;
+    }
+    int reuse = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    uint16_t port = native::hostPort(m_port);
+    sockaddr_in address = toSockaddr(IPAddress(), port);
+    if (bind(m_fd, (sockaddr*)&address, sizeof(address)) != 0 || listen(m_fd, 4) != 0) {
+        fprintf(stderr, "[native] tcp port %u: %s\n", port, strerror(errno));
+        close();
+        return;
+    }
+    fprintf(stderr, "[native] tcp port %u listens on %u\n", m_port, port);
+}
+
+void WiFiServer::close()
+{
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool WiFiServer::hasClient()
+{
+    return m_fd >= 0 && waitFor(m_fd, POLLIN, 0);
+}
+
+WiFiClient WiFiServer::accept()
+{
+    int fd = m_fd >= 0 ? accept4(m_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC) : -1;
+    if (fd < 0) {
+        return WiFiClient();
+    }
+    WiFiClient client(fd);
+    client.setNoDelay(m_noDelay);
+    return client;
+}
+
+// WiFiUDP
+
+bool WiFiUDP::open()
+{
+    if (m_fd < 0) {
+        m_fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    }
+    return m_fd >= 0;
+}
+
+uint8_t WiFiUDP::begin(uint16_t port)
+{
+    stop();
+    if (!open()) {
+        return 0;
+    }
+    uint16_t hostPort = native::hostPort(port);
+    sockaddr_in address = toSockaddr(IPAddress(), hostPort);
+    if (bind(m_fd, (sockaddr*)&address, sizeof(address)) != 0) {
+        fprintf(stderr, "[native] udp port %u: %s\n", hostPort, strerror(errno));
+        stop();
+        return 0;
+    }
+    fprintf(stderr, "[native] udp port %u listens on %u\n", port, hostPort);
+    return 1;
+}
+
+void WiFiUDP::stop()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_rx.clear();
+    m_readOffset = 0;
+}
+
+int WiFiUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+    m_txIP = ip;
+    m_txPort = port;
+    m_tx.clear();
+    return open();
+}
+
+int WiFiUDP::beginPacket(const char* host, uint16_t port)
+{
+    IPAddress ip;
+    return resolve(host, ip) ? beginPacket(ip, port) : 0;
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t size)
+{
+    size_t room = WIFI_UDP_MAX_PACKET - std::min(m_tx.size(), (size_t)WIFI_UDP_MAX_PACKET);
+    size = std::min(size, room);
+    m_tx.insert(m_tx.end(), buffer, buffer + size);
+    return size;
+}
+
+int WiFiUDP::endPacket()
+{
+    if (m_fd < 0 || !m_txPort) {
+        return 0;
+    }
+    sockaddr_in address = toSockaddr(m_txIP, m_txPort);
+    ssize_t n = sendto(m_fd, m_tx.data(), m_tx.size(), MSG_DONTWAIT, (sockaddr*)&address, sizeof(address));
+    m_tx.clear();
+    return n >= 0;
+}
+
+int WiFiUDP::parsePacket()
+{
+    m_rx.clear();
+    m_readOffset = 0;
+    if (m_fd < 0) {
+        return 0;
+    }
+    uint8_t buffer[WIFI_UDP_MAX_PACKET];
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    ssize_t n = recvfrom(m_fd, buffer, sizeof(buffer), MSG_DONTWAIT, (sockaddr*)&address, &length);
+    if (n <= 0) {
+        return 0;
+    }
+    m_rx.assign(buffer, buffer + n);
+    m_remoteIP = IPAddress((uint32_t)address.sin_addr.s_addr);
+    m_remotePort = ntohs(address.sin_port);
+    return n;
+}
+
+int WiFiUDP::read()
+{
+    return available() ? m_rx[m_readOffset++] : -1;
+}
+
+int WiFiUDP::read(unsigned char* buffer, size_t length)
+{
+    size_t count = std::min(length, (size_t)available());
+    memcpy(buffer, m_rx.data() + m_readOffset, count);
+    m_readOffset += count;
+    return count;
+}
+
+// ESP8266WiFiClass
+
+class WiFiEventHandlerOpaque { };
+
+wl_status_t ESP8266WiFiClass::begin(const char* ssid, const char* pass)
+{
+    (void)pass;
+    m_ssid = ssid ? ssid : "";
+    return begin();
+}
+
+wl_status_t ESP8266WiFiClass::begin()
+{
+    m_status = (m_mode & WIFI_STA) && !m_ssid.isEmpty() ? WL_CONNECTED : WL_DISCONNECTED;
+    return m_status;
+}
+
+bool ESP8266WiFiClass::reconnect()
+{
+    return begin() == WL_CONNECTED;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifiOff)
+{
+    if (wifiOff) {
+        m_mode = WIFI_OFF;
+    }
+    m_status = WL_DISCONNECTED;
+    return true;
+}
+
+bool ESP8266WiFiClass::softAP(const char* ssid, const char* pass, int channel, int hidden, int maxConnections)
+{
+    (void)ssid;
+    (void)pass;
+    (void)channel;
+    (void)hidden;
+    (void)maxConnections;
+    m_softAP = true;
+    return true;
+}
+
+bool ESP8266WiFiClass::softAPdisconnect(bool wifiOff)
+{
+    (void)wifiOff;
+    m_softAP = false;
+    return true;
+}
+
+WiFiEventHandler ESP8266WiFiClass::onSoftAPModeStationConnected(std::function<void(const WiFiEventSoftAPModeStationConnected&)> callback)
+{
+    (void)callback;
+    return std::make_shared<WiFiEventHandlerOpaque>();
+}
+
+WiFiEventHandler ESP8266WiFiClass::onSoftAPModeStationDisconnected(std::function<void(const WiFiEventSoftAPModeStationDisconnected&)> callback)
+{
+    (void)callback;
+    return std::make_shared<WiFiEventHandlerOpaque>();
+}
+
+WiFiEventHandler ESP8266WiFiClass::onSoftAPModeProbeRequestReceived(std::function<void(const WiFiEventSoftAPModeProbeRequestReceived&)> callback)
+{
+    (void)callback;
+    return std::make_shared<WiFiEventHandlerOpaque>();
+}
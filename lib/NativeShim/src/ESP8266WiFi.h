@@ -0,0 +1,123 @@
+#ifndef ESP8266WiFi_h
+#define ESP8266WiFi_h
+
+#include "Arduino.h"
+#include "WiFiClient.h"
+#include "WiFiServer.h"
+#include "WiFiUdp.h"
+#include <functional>
+#include <memory>
+
+enum WiFiMode_t {
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+};
+
+enum wl_status_t {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_DISCONNECTED = 6
+};
+
+struct WiFiEventSoftAPModeStationConnected {
+    uint8_t mac[6];
+    uint8_t aid;
+};
+
+struct WiFiEventSoftAPModeStationDisconnected {
+    uint8_t mac[6];
+    uint8_t aid;
+};
+
+struct WiFiEventSoftAPModeProbeRequestReceived {
+    int rssi;
+    uint8_t mac[6];
+};
+
+class WiFiEventHandlerOpaque;
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+/**
+ * The host network is always there: a station that begins with an SSID
+ * is connected at once, on the loopback address. No soft AP station
+ * ever connects, the events are accepted and never fire.
+ */
+class ESP8266WiFiClass {
+public:
+    bool mode(WiFiMode_t mode)
+    {
+        m_mode = mode;
+        return true;
+    }
+    WiFiMode_t getMode() const
+    {
+        return m_mode;
+    }
+    void persistent(bool persistent)
+    {
+        (void)persistent;
+    }
+
+    wl_status_t begin(const char* ssid, const char* pass = nullptr);
+    wl_status_t begin(const String& ssid, const String& pass = "")
+    {
+        return begin(ssid.c_str(), pass.c_str());
+    }
+    wl_status_t begin();
+    bool reconnect();
+    bool disconnect(bool wifiOff = false);
+    bool isConnected() const
+    {
+        return m_status == WL_CONNECTED;
+    }
+    wl_status_t status() const
+    {
+        return m_status;
+    }
+
+    IPAddress localIP() const
+    {
+        return isConnected() ? IPAddress(127, 0, 0, 1) : IPAddress();
+    }
+    int32_t RSSI() const
+    {
+        return isConnected() ? -55 : 31;
+    }
+    String SSID() const
+    {
+        return m_ssid;
+    }
+
+    bool softAPConfig(IPAddress local, IPAddress gateway, IPAddress subnet)
+    {
+        (void)gateway;
+        (void)subnet;
+        m_softAPIP = local;
+        return true;
+    }
+    bool softAP(const char* ssid, const char* pass = nullptr, int channel = 1, int hidden = 0, int maxConnections = 4);
+    bool softAPdisconnect(bool wifiOff = false);
+    IPAddress softAPIP() const
+    {
+        return m_softAP ? m_softAPIP : IPAddress();
+    }
+
+    WiFiEventHandler onSoftAPModeStationConnected(std::function<void(const WiFiEventSoftAPModeStationConnected&)> callback);
+    WiFiEventHandler onSoftAPModeStationDisconnected(std::function<void(const WiFiEventSoftAPModeStationDisconnected&)> callback);
+    WiFiEventHandler onSoftAPModeProbeRequestReceived(std::function<void(const WiFiEventSoftAPModeProbeRequestReceived&)> callback);
+
+private:
+    WiFiMode_t m_mode = WIFI_STA;
+    wl_status_t m_status = WL_DISCONNECTED;
+    String m_ssid;
+    bool m_softAP = false;
+    IPAddress m_softAPIP = IPAddress(192, 168, 4, 1);
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef ESP8266WiFiAP_h
+#define ESP8266WiFiAP_h
+
+// the soft AP is part of ESP8266WiFiClass
+#include "ESP8266WiFi.h"
+
+#endif
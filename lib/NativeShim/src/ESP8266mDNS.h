@@ -0,0 +1,52 @@
+#ifndef ESP8266mDNS_h
+#define ESP8266mDNS_h
+
+#include "Arduino.h"
+
+/**
+ * No multicast DNS on the host, the simulator is reached on localhost.
+ */
+class MDNSResponder {
+public:
+    bool begin(const char* hostname)
+    {
+        (void)hostname;
+        m_running = true;
+        return true;
+    }
+    bool begin(const String& hostname)
+    {
+        return begin(hostname.c_str());
+    }
+    bool isRunning() const
+    {
+        return m_running;
+    }
+    bool addService(const char* service, const char* protocol, uint16_t port)
+    {
+        (void)service;
+        (void)protocol;
+        (void)port;
+        return true;
+    }
+    bool announce()
+    {
+        return true;
+    }
+    bool update()
+    {
+        return true;
+    }
+    bool end()
+    {
+        m_running = false;
+        return true;
+    }
+
+private:
+    bool m_running = false;
+};
+
+extern MDNSResponder MDNS;
+
+#endif
@@ -0,0 +1,81 @@
+#include "Arduino.h"
+#include "NativeShim.h"
+#include <cstdio>
+#include <random>
+#include <sys/stat.h>
+
+EspClass ESP;
+
+static rst_info s_resetInfo;
+
+uint32_t EspClass::getChipId()
+{
+    return native::options.chipId;
+}
+
+uint32_t EspClass::getSketchSize()
+{
+    struct stat info;
+    return stat("/proc/self/exe", &info) == 0 ? info.st_size : 0;
+}
+
+/**
+ * Not an MD5, a stable fingerprint of the program, but with the same
+ * format and the same cost of reading the whole sketch.
+ */
+String EspClass::getSketchMD5()
+{
+    FILE* file = fopen("/proc/self/exe", "rb");
+    if (!file) {
+        return "";
+    }
+    uint64_t hash[2] = { 0xcbf29ce484222325ULL, 0x84222325cbf29ce4ULL };
+    uint8_t buffer[512];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        for (size_t i = 0; i < length; i++) {
+            hash[i & 1] = (hash[i & 1] ^ buffer[i]) * 0x100000001b3ULL;
+        }
+    }
+    fclose(file);
+
+    char md5[33];
+    snprintf(md5, sizeof(md5), "%016llx%016llx", (unsigned long long)hash[0], (unsigned long long)hash[1]);
+    return md5;
+}
+
+rst_info* EspClass::getResetInfoPtr()
+{
+    s_resetInfo.reason = native::options.resetReason;
+    return &s_resetInfo;
+}
+
+String EspClass::getResetReason()
+{
+    static const char* const reasons[] = {
+        "Power On", "Hardware Watchdog", "Exception", "Software Watchdog", "Software/System restart", "Deep-Sleep Wake", "External System"
+    };
+    uint32_t reason = getResetInfoPtr()->reason;
+    return reason < sizeof(reasons) / sizeof(reasons[0]) ? reasons[reason] : "Unknown";
+}
+
+String EspClass::getResetInfo()
+{
+    return "Fatal exception:0 flag:" + String(getResetInfoPtr()->reason) + " (" + getResetReason() + ") epc1:0x00000000 epc2:0x00000000 epc3:0x00000000 excvaddr:0x00000000 depc:0x00000000";
+}
+
+uint32_t EspClass::random()
+{
+    static std::random_device s_device;
+    return s_device();
+}
+
+void EspClass::restart()
+{
+    native::restart();
+}
+
+void EspClass::reset()
+{
+    native::restart();
+}
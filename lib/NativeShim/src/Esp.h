@@ -0,0 +1,121 @@
+#ifndef Esp_h
+#define Esp_h
+
+#include "WString.h"
+#include <cstdint>
+
+enum rst_reason {
+    REASON_DEFAULT_RST = 0,
+    REASON_WDT_RST = 1,
+    REASON_EXCEPTION_RST = 2,
+    REASON_SOFT_WDT_RST = 3,
+    REASON_SOFT_RESTART = 4,
+    REASON_DEEP_SLEEP_AWAKE = 5,
+    REASON_EXT_SYS_RST = 6,
+};
+
+struct rst_info {
+    uint32_t reason;
+    uint32_t exccause;
+    uint32_t epc1;
+    uint32_t epc2;
+    uint32_t epc3;
+    uint32_t excvaddr;
+    uint32_t depc;
+};
+
+enum FlashMode_t {
+    FM_QIO = 0x00,
+    FM_QOUT = 0x01,
+    FM_DIO = 0x02,
+    FM_DOUT = 0x03,
+    FM_UNKNOWN = 0xff
+};
+
+/**
+ * Chip information of a simulated esp-12F (4MB flash), the heap
+ * numbers are fixed, a host has no meaningful equivalent.
+ */
+class EspClass {
+public:
+    uint32_t getChipId();
+    uint32_t getFreeHeap()
+    {
+        return 40000;
+    }
+    uint32_t getMaxFreeBlockSize()
+    {
+        return 32000;
+    }
+    uint8_t getHeapFragmentation()
+    {
+        return 20;
+    }
+    uint32_t getCycleCount();
+    uint8_t getCpuFreqMHz();
+    uint16_t getVcc()
+    {
+        return 3300;
+    }
+    uint8_t getBootMode()
+    {
+        return 1;
+    }
+    uint8_t getBootVersion()
+    {
+        return 31;
+    }
+    String getCoreVersion()
+    {
+        return "native";
+    }
+    const char* getSdkVersion()
+    {
+        return "native";
+    }
+
+    uint32_t getFlashChipId()
+    {
+        return 0x1640ef;
+    }
+    FlashMode_t getFlashChipMode()
+    {
+        return FM_DIO;
+    }
+    uint32_t getFlashChipRealSize()
+    {
+        return 4 * 1024 * 1024;
+    }
+    uint32_t getFlashChipSize()
+    {
+        return 4 * 1024 * 1024;
+    }
+    uint32_t getFlashChipSizeByChipId()
+    {
+        return 4 * 1024 * 1024;
+    }
+    uint32_t getFlashChipSpeed()
+    {
+        return 40000000;
+    }
+
+    uint32_t getSketchSize();
+    String getSketchMD5();
+    uint32_t getFreeSketchSpace()
+    {
+        return getSketchSize() < 1024 * 1024 ? 1024 * 1024 - getSketchSize() : 0;
+    }
+
+    rst_info* getResetInfoPtr();
+    String getResetReason();
+    String getResetInfo();
+
+    uint32_t random();
+
+    [[noreturn]] void restart();
+    [[noreturn]] void reset();
+};
+
+extern EspClass ESP;
+
+#endif
@@ -0,0 +1,229 @@
+#include "FS.h"
+#include "NativeShim.h"
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+
+fs::FS LittleFS;
+
+namespace fs {
+
+static std::string hostPath(const std::string& path)
+{
+    return std::string(native::options.fsDir) + path;
+}
+
+static void makeParents(const std::string& path)
+{
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        ::mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+}
+
+static void loadDir(const std::string& dir, const std::string& prefix, std::map<std::string, std::shared_ptr<std::vector<uint8_t>>>& files)
+{
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) {
+        return;
+    }
+    while (dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name == "." || name == "..") {
+            continue;
+        }
+        std::string path = dir + "/" + name;
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) {
+            continue;
+        }
+        if (S_ISDIR(info.st_mode)) {
+            loadDir(path, prefix + "/" + name, files);
+            continue;
+        }
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) {
+            continue;
+        }
+        auto data = std::make_shared<std::vector<uint8_t>>(info.st_size);
+        data->resize(fread(data->data(), 1, data->size(), file));
+        fclose(file);
+        files[prefix + "/" + name] = data;
+    }
+    closedir(handle);
+}
+
+// File
+
+size_t File::write(const uint8_t* buffer, size_t size)
+{
+    if (!m_handle || !m_handle->writable) {
+        return 0;
+    }
+    std::vector<uint8_t>& data = *m_handle->data;
+    if (m_handle->position + size > data.size()) {
+        data.resize(m_handle->position + size);
+    }
+    memcpy(data.data() + m_handle->position, buffer, size);
+    m_handle->position += size;
+    m_handle->modified = true;
+    return size;
+}
+
+int File::available()
+{
+    return m_handle ? m_handle->data->size() - m_handle->position : 0;
+}
+
+int File::read()
+{
+    uint8_t c;
+    return read(&c, 1) == 1 ? c : -1;
+}
+
+size_t File::read(uint8_t* buffer, size_t size)
+{
+    size_t count = std::min(size, (size_t)available());
+    if (count) {
+        memcpy(buffer, m_handle->data->data() + m_handle->position, count);
+        m_handle->position += count;
+    }
+    return count;
+}
+
+int File::peek()
+{
+    return available() ? (*m_handle->data)[m_handle->position] : -1;
+}
+
+void File::flush()
+{
+    if (m_handle && m_handle->modified) {
+        m_handle->fs->store(m_handle->path, *m_handle->data);
+        m_handle->modified = false;
+    }
+}
+
+bool File::seek(uint32_t position)
+{
+    if (!m_handle || position > m_handle->data->size()) {
+        return false;
+    }
+    m_handle->position = position;
+    return true;
+}
+
+size_t File::position() const
+{
+    return m_handle ? m_handle->position : 0;
+}
+
+size_t File::size() const
+{
+    return m_handle ? m_handle->data->size() : 0;
+}
+
+void File::close()
+{
+    flush();
+    m_handle.reset();
+}
+
+const char* File::name() const
+{
+    if (!m_handle) {
+        return "";
+    }
+    size_t slash = m_handle->path.rfind('/');
+    return m_handle->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+// FS
+
+bool FS::begin()
+{
+    if (!m_loaded && native::options.fsDir) {
+        loadDir(native::options.fsDir, "", m_files);
+    }
+    m_loaded = true;
+    return true;
+}
+
+bool FS::format()
+{
+    while (!m_files.empty()) {
+        remove(m_files.begin()->first.c_str());
+    }
+    return true;
+}
+
+File FS::open(const char* path, const char* mode)
+{
+    auto it = m_files.find(path);
+    bool write = mode[0] == 'w' || mode[0] == 'a' || mode[1] == '+';
+    if (it == m_files.end()) {
+        if (mode[0] == 'r') {
+            return File();
+        }
+        it = m_files.emplace(path, std::make_shared<std::vector<uint8_t>>()).first;
+    } else if (mode[0] == 'w') {
+        it->second = std::make_shared<std::vector<uint8_t>>(); // open readers keep the old content
+    }
+
+    auto handle = std::make_shared<File::Handle>();
+    handle->fs = this;
+    handle->path = path;
+    handle->data = it->second;
+    handle->position = mode[0] == 'a' ? handle->data->size() : 0;
+    handle->writable = write;
+    handle->modified = mode[0] == 'w';
+    File file(handle);
+    file.flush(); // the file exists from now on
+    return file;
+}
+
+bool FS::exists(const char* path)
+{
+    return m_files.count(path) > 0;
+}
+
+bool FS::remove(const char* path)
+{
+    if (!m_files.erase(path)) {
+        return false;
+    }
+    if (native::options.fsDir) {
+        ::remove(hostPath(path).c_str());
+    }
+    return true;
+}
+
+bool FS::rename(const char* pathFrom, const char* pathTo)
+{
+    auto it = m_files.find(pathFrom);
+    if (it == m_files.end()) {
+        return false;
+    }
+    m_files[pathTo] = it->second;
+    m_files.erase(pathFrom);
+    if (native::options.fsDir) {
+        makeParents(hostPath(pathTo));
+        ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str());
+    }
+    return true;
+}
+
+void FS::store(const std::string& path, const std::vector<uint8_t>& data)
+{
+    if (!native::options.fsDir || m_files.find(path) == m_files.end()) {
+        return; // removed while it was open
+    }
+    std::string host = hostPath(path);
+    makeParents(host);
+    FILE* file = fopen(host.c_str(), "wb");
+    if (file) {
+        fwrite(data.data(), 1, data.size(), file);
+        fclose(file);
+    }
+}
+
+}
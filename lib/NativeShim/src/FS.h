@@ -0,0 +1,115 @@
+#ifndef FS_H
+#define FS_H
+
+#include "Arduino.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fs {
+
+class FS;
+
+/**
+ * Open file of the in-memory filesystem, copies share the position.
+ */
+class File : public Stream {
+public:
+    File() { }
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    int available() override;
+    int read() override;
+    size_t read(uint8_t* buffer, size_t size);
+    int peek() override;
+    void flush() override;
+
+    bool seek(uint32_t position);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    const char* name() const;
+
+    operator bool() const
+    {
+        return (bool)m_handle;
+    }
+
+private:
+    friend class FS;
+
+    struct Handle {
+        FS* fs;
+        std::string path;
+        std::shared_ptr<std::vector<uint8_t>> data;
+        size_t position;
+        bool writable;
+        bool modified;
+    };
+
+    explicit File(std::shared_ptr<Handle> handle)
+        : m_handle(handle)
+    {
+    }
+
+    std::shared_ptr<Handle> m_handle;
+};
+
+/**
+ * Flat in-memory filesystem, see native::Options::fsDir to keep it
+ * on the host between runs.
+ */
+class FS {
+public:
+    bool begin();
+    void end() { }
+    bool format();
+
+    File open(const char* path, const char* mode);
+    File open(const String& path, const char* mode)
+    {
+        return open(path.c_str(), mode);
+    }
+    bool exists(const char* path);
+    bool exists(const String& path)
+    {
+        return exists(path.c_str());
+    }
+    bool remove(const char* path);
+    bool remove(const String& path)
+    {
+        return remove(path.c_str());
+    }
+    bool rename(const char* pathFrom, const char* pathTo);
+    bool rename(const String& pathFrom, const String& pathTo)
+    {
+        return rename(pathFrom.c_str(), pathTo.c_str());
+    }
+    bool mkdir(const char* path)
+    {
+        (void)path;
+        return true; // directories only exist as a path prefix
+    }
+
+private:
+    friend class File;
+
+    void store(const std::string& path, const std::vector<uint8_t>& data);
+
+    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> m_files;
+    bool m_loaded = false;
+};
+
+}
+
+using fs::File;
+using fs::FS;
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include "Stream.h"
+
+/**
+ * Serial maps to stdout, nothing is ever received.
+ */
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long baud)
+    {
+        (void)baud;
+    }
+    void end() { }
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int availableForWrite() override
+    {
+        return 128;
+    }
+    void flush() override;
+
+    int available() override
+    {
+        return 0;
+    }
+    int read() override
+    {
+        return -1;
+    }
+    int peek() override
+    {
+        return -1;
+    }
+
+    operator bool() const
+    {
+        return true;
+    }
+};
+
+extern HardwareSerial Serial;
+
+#endif
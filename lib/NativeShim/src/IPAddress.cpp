@@ -0,0 +1,36 @@
+#include "IPAddress.h"
+#include <cstdio>
+
+bool IPAddress::fromString(const char* address)
+{
+    uint32_t result = 0;
+    uint32_t octet = 0;
+    int dots = 0;
+    int digits = 0;
+    for (const char* c = address; *c; c++) {
+        if (*c >= '0' && *c <= '9') {
+            octet = octet * 10 + (*c - '0');
+            if (++digits > 3 || octet > 255) {
+                return false;
+            }
+        } else if (*c == '.' && digits && dots < 3) {
+            result |= octet << (8 * dots++);
+            octet = 0;
+            digits = 0;
+        } else {
+            return false;
+        }
+    }
+    if (dots != 3 || !digits) {
+        return false;
+    }
+    m_address = result | octet << 24;
+    return true;
+}
+
+String IPAddress::toString() const
+{
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+    return buffer;
+}
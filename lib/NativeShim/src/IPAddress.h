@@ -0,0 +1,58 @@
+#ifndef IPAddress_h
+#define IPAddress_h
+
+#include "WString.h"
+#include <cstdint>
+
+/**
+ * IPv4 address, stored in network byte order like the core.
+ */
+class IPAddress {
+public:
+    IPAddress()
+        : m_address(0)
+    {
+    }
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+        : m_address((uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24)
+    {
+    }
+    IPAddress(uint32_t address)
+        : m_address(address)
+    {
+    }
+
+    bool fromString(const char* address);
+    bool fromString(const String& address)
+    {
+        return fromString(address.c_str());
+    }
+    String toString() const;
+
+    bool isSet() const
+    {
+        return m_address != 0;
+    }
+
+    operator uint32_t() const
+    {
+        return m_address;
+    }
+    uint8_t operator[](int index) const
+    {
+        return m_address >> (8 * index);
+    }
+    bool operator==(const IPAddress& rhs) const
+    {
+        return m_address == rhs.m_address;
+    }
+    bool operator!=(const IPAddress& rhs) const
+    {
+        return m_address != rhs.m_address;
+    }
+
+private:
+    uint32_t m_address;
+};
+
+#endif
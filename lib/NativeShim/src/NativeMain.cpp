@@ -0,0 +1,96 @@
+#include "Arduino.h"
+#include "NativeShim.h"
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+static std::vector<std::string> s_args;
+
+static void usage(const char* program)
+{
+    fprintf(stderr,
+        "usage: %s [--virtual-time] [--tick-us <us>] [--port-offset <n>] [--gpio-trace]\n"
+        "       [--fs-dir <dir>] [--chip-id <hex>] [--reset-reason <n>] [-- <sketch args>]\n",
+        program);
+}
+
+static bool parseOptions(int argc, char** argv)
+{
+    native::Options& options = native::options;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!strcmp(arg, "--")) {
+            options.sketchArgc = argc - i - 1;
+            options.sketchArgs = argv + i + 1;
+            break;
+        } else if (!strcmp(arg, "--virtual-time")) {
+            options.virtualTime = true;
+        } else if (!strcmp(arg, "--gpio-trace")) {
+            options.gpioTrace = true;
+        } else if (!value) {
+            return false;
+        } else if (!strcmp(arg, "--tick-us")) {
+            options.tickUs = strtoul(value, nullptr, 10);
+            i++;
+        } else if (!strcmp(arg, "--port-offset")) {
+            options.portOffset = strtoul(value, nullptr, 10);
+            i++;
+        } else if (!strcmp(arg, "--fs-dir")) {
+            options.fsDir = value;
+            i++;
+        } else if (!strcmp(arg, "--chip-id")) {
+            options.chipId = strtoul(value, nullptr, 16);
+            i++;
+        } else if (!strcmp(arg, "--reset-reason")) {
+            options.resetReason = strtoul(value, nullptr, 10);
+            i++;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+void native::restart()
+{
+    fflush(stdout);
+    fprintf(stderr, "[native] restart\n");
+
+    // same options, only the reset reason changes, sockets are closed on exec
+    static char reasonOption[] = "--reset-reason";
+    static char reason[] = "4"; // REASON_SOFT_RESTART
+    std::vector<char*> argv = { &s_args[0][0], reasonOption, reason };
+    bool sketchArgs = false;
+    for (size_t i = 1; i < s_args.size(); i++) {
+        sketchArgs |= s_args[i] == "--";
+        if (!sketchArgs && s_args[i] == "--reset-reason") {
+            i++;
+            continue;
+        }
+        argv.push_back(&s_args[i][0]);
+    }
+    argv.push_back(nullptr);
+    execv("/proc/self/exe", argv.data());
+
+    perror("[native] restart failed");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    s_args.assign(argv, argv + argc);
+    if (!parseOptions(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    setup();
+    while (true) {
+        loop();
+        native::serviceTimers();
+        native::advanceUs(native::options.tickUs);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef NativeShim_h
+#define NativeShim_h
+
+#include <cstdint>
+
+/**
+ * Simulator state of the native build.
+ *
+ * Options (command line of the program):
+ * --virtual-time: millis() and micros() only advance with delay(),
+ *     yield() and the loop tick, a run doesn't depend on the host load
+ * --tick-us <us>: pause after every loop() call (virtual time advances
+ *     by it instead), default 1000
+ * --port-offset <n>: added to every tcp/udp port below 1024, default 8000
+ *     so the webserver (443) listens on 8443
+ * --gpio-trace: print every output change to stderr
+ * --fs-dir <dir>: keep the filesystem in a host directory, it's loaded
+ *     at LittleFS.begin() and written through, default in memory only
+ * --chip-id <hex>: ESP.getChipId(), gives every instance its own device id
+ * --reset-reason <n>: rst_reason reported by ESP.getResetInfoPtr()
+ * -- <args>: everything after it is left to the sketch (sketchArgs)
+ *
+ * ESP.restart() starts the program again with the same options.
+ *
+ * ussage e.g.:
+ * .pio/build/native/program --virtual-time --gpio-trace
+ */
+namespace native {
+
+struct Options {
+    bool virtualTime = false;
+    uint32_t tickUs = 1000;
+    uint16_t portOffset = 8000;
+    bool gpioTrace = false;
+    const char* fsDir = nullptr;
+    uint32_t chipId = 0x5a3c1e;
+    uint32_t resetReason = 0;
+    int sketchArgc = 0;
+    char** sketchArgs = nullptr;
+};
+
+extern Options options;
+
+/**
+ * Elapsed (virtual) time since the start of the program.
+ */
+uint64_t nowUs();
+void advanceUs(uint64_t us);
+
+/**
+ * Port the host socket uses for a firmware port.
+ */
+uint16_t hostPort(uint16_t port);
+
+/**
+ * Last written level of a pin and the amount of changes, pins 0..16.
+ */
+uint8_t gpioLevel(uint8_t pin);
+uint32_t gpioChanges(uint8_t pin);
+
+/**
+ * Run the due Ticker callbacks, called from yield() and delay().
+ */
+void serviceTimers();
+
+[[noreturn]] void restart();
+
+}
+
+#endif
@@ -0,0 +1,62 @@
+#include "ArduinoOTA.h"
+#include "DNSServer.h"
+#include "ESP8266mDNS.h"
+
+MDNSResponder MDNS;
+ArduinoOTAClass ArduinoOTA;
+
+bool DNSServer::start(const uint16_t port, const String& domainName, const IPAddress& resolvedIP)
+{
+    m_domainName = domainName;
+    m_resolvedIP = resolvedIP;
+    return m_udp.begin(port);
+}
+
+void DNSServer::processNextRequest()
+{
+    int size = m_udp.parsePacket();
+    if (size < 12 || size > 512) {
+        return;
+    }
+    uint8_t packet[512 + 16];
+    m_udp.read(packet, size);
+    if (packet[2] & 0x80) {
+        return; // a response
+    }
+
+    // questions: labels, type (2), class (2), only the first one is answered
+    int end = 12;
+    while (end < size && packet[end]) {
+        end += packet[end] + 1;
+    }
+    end += 5;
+    bool query = packet[4] == 0 && packet[5] == 1 && end <= size;
+    bool typeA = query && packet[end - 4] == 0 && packet[end - 3] == 1;
+    bool wildcard = m_domainName == "*";
+
+    packet[2] = 0x84 | (packet[2] & 0x01); // response, authoritative, keep RD
+    packet[3] = 0;
+    if (!typeA || !wildcard) {
+        packet[3] = (uint8_t)m_errorReplyCode;
+        packet[6] = packet[7] = 0;
+        m_udp.beginPacket(m_udp.remoteIP(), m_udp.remotePort());
+        m_udp.write(packet, query ? end : 12);
+        m_udp.endPacket();
+        return;
+    }
+
+    packet[6] = 0;
+    packet[7] = 1; // one answer
+    packet[8] = packet[9] = packet[10] = packet[11] = 0;
+    const uint8_t answer[] = {
+        0xc0, 0x0c, // name: pointer to the question
+        0x00, 0x01, 0x00, 0x01, // A, IN
+        (uint8_t)(m_ttl >> 24), (uint8_t)(m_ttl >> 16), (uint8_t)(m_ttl >> 8), (uint8_t)m_ttl,
+        0x00, 0x04,
+        m_resolvedIP[0], m_resolvedIP[1], m_resolvedIP[2], m_resolvedIP[3]
+    };
+    m_udp.beginPacket(m_udp.remoteIP(), m_udp.remotePort());
+    m_udp.write(packet, end);
+    m_udp.write(answer, sizeof(answer));
+    m_udp.endPacket();
+}
@@ -0,0 +1,37 @@
+#ifndef Stream_h
+#define Stream_h
+
+#include "Print.h"
+
+/**
+ * Same interface as the core Stream, without the parse helpers.
+ */
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    virtual size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length)
+    {
+        return readBytes((char*)buffer, length);
+    }
+    String readString();
+
+    void setTimeout(unsigned long timeout)
+    {
+        m_timeout = timeout;
+    }
+    unsigned long getTimeout() const
+    {
+        return m_timeout;
+    }
+
+protected:
+    int timedRead();
+
+    unsigned long m_timeout = 1000;
+};
+
+#endif
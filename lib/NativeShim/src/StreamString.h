@@ -0,0 +1,46 @@
+#ifndef StreamString_h
+#define StreamString_h
+
+#include "Arduino.h"
+
+/**
+ * A String that can be printed to and read from, like the core.
+ */
+class StreamString : public String, public Stream {
+public:
+    size_t write(uint8_t c) override
+    {
+        concat((char)c);
+        return 1;
+    }
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        concat((const char*)buffer, size);
+        return size;
+    }
+    using Print::write;
+
+    int availableForWrite() override
+    {
+        return 256;
+    }
+    int available() override
+    {
+        return length();
+    }
+    int read() override
+    {
+        if (!length()) {
+            return -1;
+        }
+        char c = charAt(0);
+        remove(0, 1);
+        return (uint8_t)c;
+    }
+    int peek() override
+    {
+        return length() ? (uint8_t)charAt(0) : -1;
+    }
+};
+
+#endif
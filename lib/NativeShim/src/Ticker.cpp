@@ -0,0 +1,71 @@
+#include "Ticker.h"
+#include "NativeShim.h"
+#include <algorithm>
+#include <vector>
+
+static std::vector<Ticker*>& tickers()
+{
+    static std::vector<Ticker*> s_tickers;
+    return s_tickers;
+}
+
+Ticker::Ticker()
+    : m_periodUs(0)
+    , m_nextUs(0)
+    , m_repeat(false)
+{
+    tickers().push_back(this);
+}
+
+Ticker::~Ticker()
+{
+    std::vector<Ticker*>& list = tickers();
+    list.erase(std::remove(list.begin(), list.end(), this), list.end());
+}
+
+void Ticker::start(uint32_t milliseconds, callback_function_t callback, bool repeat)
+{
+    m_callback = callback;
+    m_periodUs = (uint64_t)milliseconds * 1000;
+    m_nextUs = native::nowUs() + m_periodUs;
+    m_repeat = repeat;
+}
+
+void Ticker::detach()
+{
+    m_callback = nullptr;
+}
+
+void Ticker::service(uint64_t nowUs)
+{
+    if (!m_callback || nowUs < m_nextUs) {
+        return;
+    }
+    callback_function_t callback = m_callback;
+    if (m_repeat) {
+        m_nextUs += m_periodUs;
+        if (m_nextUs <= nowUs) {
+            m_nextUs = nowUs + m_periodUs; // skip missed periods, like a late timer
+        }
+    } else {
+        m_callback = nullptr;
+    }
+    callback();
+}
+
+void native::serviceTimers()
+{
+    static bool s_busy = false;
+    if (s_busy) {
+        return; // a callback that yields
+    }
+    s_busy = true;
+    uint64_t now = nowUs();
+    std::vector<Ticker*> list = tickers(); // a callback may (de)construct a ticker
+    for (Ticker* ticker : list) {
+        if (std::find(tickers().begin(), tickers().end(), ticker) != tickers().end()) {
+            ticker->service(now);
+        }
+    }
+    s_busy = false;
+}
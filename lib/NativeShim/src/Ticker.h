@@ -0,0 +1,54 @@
+#ifndef Ticker_h
+#define Ticker_h
+
+#include <cstdint>
+#include <functional>
+
+/**
+ * Periodic callback, run from yield(), delay() and between two loop()
+ * calls instead of from a timer interrupt.
+ */
+class Ticker {
+public:
+    typedef std::function<void(void)> callback_function_t;
+
+    Ticker();
+    ~Ticker();
+
+    void attach(float seconds, callback_function_t callback)
+    {
+        attach_ms(seconds * 1000, callback);
+    }
+    void attach_ms(uint32_t milliseconds, callback_function_t callback)
+    {
+        start(milliseconds, callback, true);
+    }
+    void once(float seconds, callback_function_t callback)
+    {
+        once_ms(seconds * 1000, callback);
+    }
+    void once_ms(uint32_t milliseconds, callback_function_t callback)
+    {
+        start(milliseconds, callback, false);
+    }
+    void detach();
+    bool active() const
+    {
+        return (bool)m_callback;
+    }
+
+    /**
+     * Call the callback if it's due.
+     */
+    void service(uint64_t nowUs);
+
+private:
+    void start(uint32_t milliseconds, callback_function_t callback, bool repeat);
+
+    callback_function_t m_callback;
+    uint64_t m_periodUs;
+    uint64_t m_nextUs;
+    bool m_repeat;
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include "WString.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+static std::string toBase(unsigned long long value, unsigned char base, bool negative)
+{
+    if (base < 2 || base > 36) {
+        base = 10;
+    }
+    std::string digits;
+    do {
+        unsigned digit = value % base;
+        digits += (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= base;
+    } while (value);
+    if (negative) {
+        digits += '-';
+    }
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+static std::string toSigned(long long value, unsigned char base)
+{
+    // like the core, only base 10 gets a sign, other bases show the two's complement
+    if (base == 10) {
+        return toBase(value < 0 ? 0ULL - (unsigned long long)value : value, base, value < 0);
+    }
+    return toBase((unsigned long)value, base, false);
+}
+
+static std::string toDecimals(double value, unsigned char decimals)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, value);
+    return buffer;
+}
+
+String::String(unsigned char value, unsigned char base)
+    : m_buffer(toBase(value, base, false))
+{
+}
+
+String::String(int value, unsigned char base)
+    : m_buffer(base == 10 ? toSigned(value, base) : toBase((unsigned int)value, base, false))
+{
+}
+
+String::String(unsigned int value, unsigned char base)
+    : m_buffer(toBase(value, base, false))
+{
+}
+
+String::String(long value, unsigned char base)
+    : m_buffer(toSigned(value, base))
+{
+}
+
+String::String(unsigned long value, unsigned char base)
+    : m_buffer(toBase(value, base, false))
+{
+}
+
+String::String(long long value, unsigned char base)
+    : m_buffer(toSigned(value, base))
+{
+}
+
+String::String(unsigned long long value, unsigned char base)
+    : m_buffer(toBase(value, base, false))
+{
+}
+
+String::String(float value, unsigned char decimals)
+    : m_buffer(toDecimals(value, decimals))
+{
+}
+
+String::String(double value, unsigned char decimals)
+    : m_buffer(toDecimals(value, decimals))
+{
+}
+
+void String::toLowerCase()
+{
+    for (char& c : m_buffer) {
+        c = tolower((unsigned char)c);
+    }
+}
+
+void String::toUpperCase()
+{
+    for (char& c : m_buffer) {
+        c = toupper((unsigned char)c);
+    }
+}
+
+void String::trim()
+{
+    size_t begin = m_buffer.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos) {
+        m_buffer.clear();
+        return;
+    }
+    size_t end = m_buffer.find_last_not_of(" \t\r\n");
+    m_buffer = m_buffer.substr(begin, end - begin + 1);
+}
+
+void String::replace(const String& find, const String& replace)
+{
+    if (find.isEmpty()) {
+        return;
+    }
+    size_t index = 0;
+    while ((index = m_buffer.find(find.m_buffer, index)) != std::string::npos) {
+        m_buffer.replace(index, find.length(), replace.m_buffer);
+        index += replace.length();
+    }
+}
+
+void String::getBytes(unsigned char* buffer, unsigned int size, unsigned int index) const
+{
+    if (!size || !buffer) {
+        return;
+    }
+    if (index >= length()) {
+        buffer[0] = 0;
+        return;
+    }
+    unsigned int count = std::min(size - 1, length() - index);
+    memcpy(buffer, c_str() + index, count);
+    buffer[count] = 0;
+}
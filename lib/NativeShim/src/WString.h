@@ -0,0 +1,253 @@
+#ifndef WString_h
+#define WString_h
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <strings.h>
+#include <type_traits>
+#include <utility>
+
+class __FlashStringHelper;
+#define FPSTR(pstr_pointer) (reinterpret_cast<const __FlashStringHelper*>(pstr_pointer))
+#define F(string_literal) (FPSTR(string_literal))
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+/**
+ * Arduino String on top of std::string, only the part of the
+ * API that the firmware and its libraries use.
+ */
+class String {
+public:
+    String(const char* cstr = "")
+        : m_buffer(cstr ? cstr : "")
+    {
+    }
+    String(const char* cstr, size_t length)
+        : m_buffer(cstr, length)
+    {
+    }
+    String(const std::string& str)
+        : m_buffer(str)
+    {
+    }
+    String(const __FlashStringHelper* str)
+        : m_buffer(str ? reinterpret_cast<const char*>(str) : "")
+    {
+    }
+    explicit String(char c)
+        : m_buffer(1, c)
+    {
+    }
+    explicit String(unsigned char value, unsigned char base = 10);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimals = 2);
+    explicit String(double value, unsigned char decimals = 2);
+
+    unsigned int length() const
+    {
+        return m_buffer.length();
+    }
+    bool isEmpty() const
+    {
+        return m_buffer.empty();
+    }
+    const char* c_str() const
+    {
+        return m_buffer.c_str();
+    }
+    char* begin()
+    {
+        return &m_buffer[0];
+    }
+    char* end()
+    {
+        return begin() + length();
+    }
+    bool reserve(unsigned int size)
+    {
+        m_buffer.reserve(size);
+        return true;
+    }
+
+    bool concat(const String& str)
+    {
+        m_buffer += str.m_buffer;
+        return true;
+    }
+    bool concat(const char* cstr)
+    {
+        m_buffer += cstr ? cstr : "";
+        return true;
+    }
+    bool concat(const char* cstr, unsigned int length)
+    {
+        m_buffer.append(cstr, length);
+        return true;
+    }
+    bool concat(const __FlashStringHelper* str)
+    {
+        return concat(reinterpret_cast<const char*>(str));
+    }
+    bool concat(char c)
+    {
+        m_buffer += c;
+        return true;
+    }
+    template <typename T>
+    bool concat(T value)
+    {
+        return concat(String(value));
+    }
+
+    template <typename T>
+    String& operator+=(const T& rhs)
+    {
+        concat(rhs);
+        return *this;
+    }
+
+    char charAt(unsigned int index) const
+    {
+        return index < length() ? m_buffer[index] : 0;
+    }
+    char operator[](unsigned int index) const
+    {
+        return charAt(index);
+    }
+    char& operator[](unsigned int index)
+    {
+        return m_buffer[index];
+    }
+
+    int indexOf(char c, unsigned int from = 0) const
+    {
+        size_t index = m_buffer.find(c, from);
+        return index == std::string::npos ? -1 : (int)index;
+    }
+    int indexOf(const String& str, unsigned int from = 0) const
+    {
+        size_t index = m_buffer.find(str.m_buffer, from);
+        return index == std::string::npos ? -1 : (int)index;
+    }
+    int lastIndexOf(char c) const
+    {
+        size_t index = m_buffer.rfind(c);
+        return index == std::string::npos ? -1 : (int)index;
+    }
+    String substring(unsigned int from) const
+    {
+        return from < length() ? String(m_buffer.substr(from)) : String();
+    }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > to) {
+            std::swap(from, to);
+        }
+        return from < length() ? String(m_buffer.substr(from, to - from)) : String();
+    }
+    bool startsWith(const String& prefix) const
+    {
+        return m_buffer.compare(0, prefix.length(), prefix.m_buffer) == 0;
+    }
+    bool endsWith(const String& suffix) const
+    {
+        return length() >= suffix.length() && m_buffer.compare(length() - suffix.length(), suffix.length(), suffix.m_buffer) == 0;
+    }
+    bool equals(const String& str) const
+    {
+        return m_buffer == str.m_buffer;
+    }
+    bool equalsIgnoreCase(const String& str) const
+    {
+        return strcasecmp(c_str(), str.c_str()) == 0;
+    }
+
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+    void replace(const String& find, const String& replace);
+    void remove(unsigned int index, unsigned int count = (unsigned int)-1)
+    {
+        if (index < length()) {
+            m_buffer.erase(index, count);
+        }
+    }
+
+    long toInt() const
+    {
+        return strtol(c_str(), nullptr, 10);
+    }
+    float toFloat() const
+    {
+        return strtof(c_str(), nullptr);
+    }
+    double toDouble() const
+    {
+        return strtod(c_str(), nullptr);
+    }
+
+    void getBytes(unsigned char* buffer, unsigned int size, unsigned int index = 0) const;
+    void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const
+    {
+        getBytes((unsigned char*)buffer, size, index);
+    }
+
+    bool operator==(const String& rhs) const
+    {
+        return m_buffer == rhs.m_buffer;
+    }
+    bool operator==(const char* rhs) const
+    {
+        return m_buffer == (rhs ? rhs : "");
+    }
+    bool operator!=(const String& rhs) const
+    {
+        return !(*this == rhs);
+    }
+    bool operator!=(const char* rhs) const
+    {
+        return !(*this == rhs);
+    }
+    bool operator<(const String& rhs) const
+    {
+        return m_buffer < rhs.m_buffer;
+    }
+
+    friend String operator+(const String& lhs, const String& rhs)
+    {
+        return String(lhs.m_buffer + rhs.m_buffer);
+    }
+    friend String operator+(const String& lhs, const char* rhs)
+    {
+        return String(lhs.m_buffer + (rhs ? rhs : ""));
+    }
+    friend String operator+(const char* lhs, const String& rhs)
+    {
+        return String((lhs ? lhs : "") + rhs.m_buffer);
+    }
+    friend String operator+(const String& lhs, const __FlashStringHelper* rhs)
+    {
+        return lhs + reinterpret_cast<const char*>(rhs);
+    }
+    template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    friend String operator+(const String& lhs, T rhs)
+    {
+        return lhs + String(rhs);
+    }
+
+private:
+    std::string m_buffer;
+};
+
+#endif
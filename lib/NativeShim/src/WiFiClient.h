@@ -0,0 +1,82 @@
+#ifndef WiFiClient_h
+#define WiFiClient_h
+
+#include "Client.h"
+#include <memory>
+
+/**
+ * TCP client on a host socket.
+ *
+ * Like the core, copies share the connection, stop() closes it for every
+ * copy, the socket itself is closed when the last copy is gone.
+ * Reads never block, writes wait at most the stream timeout.
+ */
+class WiFiClient : public Client {
+public:
+    WiFiClient() { }
+    explicit WiFiClient(int fd);
+
+    int connect(IPAddress ip, uint16_t port) override;
+    int connect(const char* host, uint16_t port) override;
+    int connect(const String& host, uint16_t port)
+    {
+        return connect(host.c_str(), port);
+    }
+
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+    int availableForWrite() override;
+
+    int available() override;
+    int read() override;
+    int read(uint8_t* buffer, size_t size) override;
+    int read(char* buffer, size_t size)
+    {
+        return read((uint8_t*)buffer, size);
+    }
+    int peek() override;
+
+    /**
+     * Wait until the peer got everything that was written.
+     */
+    void flush() override;
+    void stop() override;
+    uint8_t connected() override;
+    operator bool() override
+    {
+        return connected();
+    }
+
+    IPAddress remoteIP();
+    uint16_t remotePort();
+    IPAddress localIP();
+    uint16_t localPort();
+
+    void setNoDelay(bool noDelay);
+    void keepAlive() { }
+
+protected:
+    struct Socket {
+        explicit Socket(int fd)
+            : fd(fd)
+        {
+        }
+        ~Socket();
+        void close();
+
+        int fd;
+    };
+
+    int fd() const
+    {
+        return m_socket ? m_socket->fd : -1;
+    }
+
+    std::shared_ptr<Socket> m_socket;
+};
+
+#endif
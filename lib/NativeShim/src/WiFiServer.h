@@ -0,0 +1,54 @@
+#ifndef WiFiServer_h
+#define WiFiServer_h
+
+#include "WiFiClient.h"
+
+/**
+ * Listening TCP socket, the port is mapped with native::hostPort().
+ */
+class WiFiServer {
+public:
+    explicit WiFiServer(uint16_t port)
+        : m_port(port)
+        , m_fd(-1)
+        , m_noDelay(false)
+    {
+    }
+    ~WiFiServer()
+    {
+        close();
+    }
+
+    void begin();
+    void close();
+    void stop()
+    {
+        close();
+    }
+
+    bool hasClient();
+    /**
+     * @return the next pending connection, an unconnected client if none
+     */
+    WiFiClient accept();
+    WiFiClient available()
+    {
+        return accept();
+    }
+
+    void setNoDelay(bool noDelay)
+    {
+        m_noDelay = noDelay;
+    }
+    uint16_t port() const
+    {
+        return m_port;
+    }
+
+private:
+    uint16_t m_port;
+    int m_fd;
+    bool m_noDelay;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef WiFiUdp_h
+#define WiFiUdp_h
+
+#include "Udp.h"
+#include <vector>
+
+/**
+ * UDP on a host socket, a bound port is mapped with native::hostPort(),
+ * destination ports are used as they are.
+ */
+class WiFiUDP : public UDP {
+public:
+    WiFiUDP()
+        : m_fd(-1)
+        , m_readOffset(0)
+        , m_remotePort(0)
+        , m_txPort(0)
+    {
+    }
+    ~WiFiUDP()
+    {
+        stop();
+    }
+    WiFiUDP(const WiFiUDP&) = delete;
+    WiFiUDP& operator=(const WiFiUDP&) = delete;
+
+    uint8_t begin(uint16_t port) override;
+    void stop() override;
+
+    int beginPacket(IPAddress ip, uint16_t port) override;
+    int beginPacket(const char* host, uint16_t port) override;
+    int endPacket() override;
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    using Print::write;
+
+    int parsePacket() override;
+    int available() override
+    {
+        return m_rx.size() - m_readOffset;
+    }
+    int read() override;
+    int read(unsigned char* buffer, size_t length) override;
+    int read(char* buffer, size_t length) override
+    {
+        return read((unsigned char*)buffer, length);
+    }
+    int peek() override
+    {
+        return available() ? m_rx[m_readOffset] : -1;
+    }
+    /**
+     * Drop the rest of the received packet.
+     */
+    void flush() override
+    {
+        m_readOffset = m_rx.size();
+    }
+
+    IPAddress remoteIP() override
+    {
+        return m_remoteIP;
+    }
+    uint16_t remotePort() override
+    {
+        return m_remotePort;
+    }
+
+private:
+    bool open();
+
+    int m_fd;
+    std::vector<uint8_t> m_rx;
+    size_t m_readOffset;
+    IPAddress m_remoteIP;
+    uint16_t m_remotePort;
+    std::vector<uint8_t> m_tx;
+    IPAddress m_txIP;
+    uint16_t m_txPort;
+};
+
+#endif
@@ -0,0 +1,152 @@
+#include "bearssl.h"
+#include <cstring>
+
+const br_hash_class br_sha256_vtable = { br_sha256_SIZE };
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static inline uint32_t rotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+static void compress(uint32_t* state, const uint8_t* block)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void br_sha256_init(br_sha256_context* ctx)
+{
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(ctx->state, initial, sizeof(initial));
+    ctx->count = 0;
+}
+
+void br_sha256_update(br_sha256_context* ctx, const void* data, size_t len)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    while (len) {
+        size_t offset = ctx->count % br_sha256_BLOCK_SIZE;
+        size_t part = br_sha256_BLOCK_SIZE - offset < len ? br_sha256_BLOCK_SIZE - offset : len;
+        memcpy(ctx->buffer + offset, bytes, part);
+        ctx->count += part;
+        bytes += part;
+        len -= part;
+        if (offset + part == br_sha256_BLOCK_SIZE) {
+            compress(ctx->state, ctx->buffer);
+        }
+    }
+}
+
+void br_sha256_out(const br_sha256_context* ctx, void* out)
+{
+    br_sha256_context copy = *ctx;
+    uint64_t bits = copy.count * 8;
+    uint8_t padding = 0x80;
+    br_sha256_update(&copy, &padding, 1);
+    padding = 0;
+    while (copy.count % br_sha256_BLOCK_SIZE != br_sha256_BLOCK_SIZE - 8) {
+        br_sha256_update(&copy, &padding, 1);
+    }
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++) {
+        length[i] = bits >> (56 - 8 * i);
+    }
+    br_sha256_update(&copy, length, sizeof(length));
+
+    uint8_t* digest = (uint8_t*)out;
+    for (int i = 0; i < 8; i++) {
+        digest[4 * i] = copy.state[i] >> 24;
+        digest[4 * i + 1] = copy.state[i] >> 16;
+        digest[4 * i + 2] = copy.state[i] >> 8;
+        digest[4 * i + 3] = copy.state[i];
+    }
+}
+
+void br_hmac_key_init(br_hmac_key_context* kc, const br_hash_class* digest_vtable, const void* key, size_t key_len)
+{
+    uint8_t block[br_sha256_BLOCK_SIZE] = {};
+    if (key_len > br_sha256_BLOCK_SIZE) {
+        br_sha256_context ctx;
+        br_sha256_init(&ctx);
+        br_sha256_update(&ctx, key, key_len);
+        br_sha256_out(&ctx, block);
+    } else {
+        memcpy(block, key, key_len);
+    }
+    kc->dig_vtable = digest_vtable;
+    for (size_t i = 0; i < br_sha256_BLOCK_SIZE; i++) {
+        kc->ksi[i] = block[i] ^ 0x36;
+        kc->kso[i] = block[i] ^ 0x5c;
+    }
+}
+
+void br_hmac_init(br_hmac_context* ctx, const br_hmac_key_context* kc, size_t out_len)
+{
+    br_sha256_init(&ctx->inner);
+    br_sha256_update(&ctx->inner, kc->ksi, sizeof(kc->ksi));
+    memcpy(ctx->kso, kc->kso, sizeof(kc->kso));
+    ctx->out_len = out_len && out_len < br_sha256_SIZE ? out_len : br_sha256_SIZE;
+}
+
+void br_hmac_update(br_hmac_context* ctx, const void* data, size_t len)
+{
+    br_sha256_update(&ctx->inner, data, len);
+}
+
+size_t br_hmac_out(const br_hmac_context* ctx, void* out)
+{
+    uint8_t inner[br_sha256_SIZE];
+    br_sha256_out(&ctx->inner, inner);
+
+    br_sha256_context outer;
+    br_sha256_init(&outer);
+    br_sha256_update(&outer, ctx->kso, sizeof(ctx->kso));
+    br_sha256_update(&outer, inner, sizeof(inner));
+    uint8_t digest[br_sha256_SIZE];
+    br_sha256_out(&outer, digest);
+    memcpy(out, digest, ctx->out_len);
+    return ctx->out_len;
+}
@@ -0,0 +1,53 @@
+#ifndef bearssl_h
+#define bearssl_h
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The part of BearSSL the firmware uses directly: SHA-256 and HMAC.
+ */
+
+#define BR_KEYTYPE_RSA 1
+#define BR_KEYTYPE_EC 2
+
+#define br_sha256_SIZE 32
+#define br_sha256_BLOCK_SIZE 64
+
+typedef struct {
+    uint8_t buffer[br_sha256_BLOCK_SIZE];
+    uint32_t state[8];
+    uint64_t count;
+} br_sha256_context;
+
+void br_sha256_init(br_sha256_context* ctx);
+void br_sha256_update(br_sha256_context* ctx, const void* data, size_t len);
+void br_sha256_out(const br_sha256_context* ctx, void* out);
+
+/**
+ * Only SHA-256 is available, the vtable just tells it apart.
+ */
+typedef struct {
+    size_t desc;
+} br_hash_class;
+
+extern const br_hash_class br_sha256_vtable;
+
+typedef struct {
+    const br_hash_class* dig_vtable;
+    uint8_t ksi[br_sha256_BLOCK_SIZE];
+    uint8_t kso[br_sha256_BLOCK_SIZE];
+} br_hmac_key_context;
+
+typedef struct {
+    br_sha256_context inner;
+    uint8_t kso[br_sha256_BLOCK_SIZE];
+    size_t out_len;
+} br_hmac_context;
+
+void br_hmac_key_init(br_hmac_key_context* kc, const br_hash_class* digest_vtable, const void* key, size_t key_len);
+void br_hmac_init(br_hmac_context* ctx, const br_hmac_key_context* kc, size_t out_len);
+void br_hmac_update(br_hmac_context* ctx, const void* data, size_t len);
+size_t br_hmac_out(const br_hmac_context* ctx, void* out);
+
+#endif
@@ -0,0 +1,67 @@
+import argparse
+import asyncio
+import json
+import logging
+
+from smartHuePy.helpers.helpers import SetupHelper
+from smartHuePy.helpers import loadtest
+
+logging.basicConfig(level=logging.INFO)
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='SmartHue Load Test')
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument('-d', '--devices', type=argparse.FileType('r'))
+    target.add_argument('-u', '--url', help='e.g. http://localhost:8443 for the native simulator')
+    parser.add_argument('-c', '--concurrency', type=int, default=4)
+    parser.add_argument('-m', '--mix', type=loadtest.parse_mix, default=loadtest.DEFAULT_MIX,
+                        help='weighted request mix, operations: %s' % ', '.join(sorted(loadtest.OPERATIONS)))
+    parser.add_argument('-t', '--duration', type=float, default=30.0, help='seconds')
+    parser.add_argument('-n', '--requests', type=int, help='total amount of requests, instead of a duration')
+    parser.add_argument('--timeout', type=float, default=5.0, help='seconds per request')
+    parser.add_argument('--heap-interval', type=float, default=2.0, help='seconds between heap samples')
+    parser.add_argument('--relay', type=int, default=1)
+    parser.add_argument('--seed', type=int)
+    parser.add_argument('--encoding', choices=['json', 'cbor'], default='json')
+    parser.add_argument('-o', '--output', type=argparse.FileType('w'))
+    return parser.parse_args()
+
+
+def get_config(config):
+    config_load = json.loads(config.read())
+    config.close()
+    return config_load
+
+
+def main():
+    args = parse_args()
+    setup = SetupHelper()
+    if args.url:
+        hostnames = [args.url]
+        setup.add(args.url, args.url)
+    else:
+        hostnames = get_config(args.devices)["devices"]["test"]
+        for name in hostnames:
+            setup.add(name)
+
+    results = []
+    for name in hostnames:
+        device = setup.get(name)
+        device.encoding = args.encoding
+        if not device.get_version():
+            logging.info("%s: device is not up" % device.hostname)
+            continue
+
+        load_test = loadtest.LoadTest(device, concurrency=args.concurrency, mix=args.mix,
+                                      duration=args.duration, max_requests=args.requests, timeout=args.timeout,
+                                      heap_interval=args.heap_interval, relay=args.relay, seed=args.seed)
+        results.append(asyncio.run(load_test.run()))
+
+    if args.output:
+        json.dump(results, args.output, indent=4)
+        args.output.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,189 @@
+import logging
+import socket
+import ssl
+import statistics
+import time
+
+from smartHuePy.helpers.smarthueapi import tls_context
+from smartHuePy.helpers.udpcontrol import UdpControl
+
+
+def percentile(samples, pct):
+    if not samples:
+        return 0.0
+    ordered = sorted(samples)
+    index = min(len(ordered) - 1, int(round(pct / 100.0 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def heap_snapshot(device):
+    system_info = device.get_system_info()
+    if not system_info:
+        return None
+    return {
+        "free_heap": system_info.get("free_heap"),
+        "max_free_block_size": system_info.get("max_free_block_size"),
+        "heap_fragmentation": system_info.get("heap_fragmentation"),
+    }
+
+
+def time_call(cb, iterations=20, warmup=2):
+    """
+    call cb a number of times and return the latency of each successful call in ms
+    """
+    for _ in range(warmup):
+        cb()
+
+    samples = []
+    errors = 0
+    for _ in range(iterations):
+        time_start = time.perf_counter()
+        result = cb()
+        time_diff = (time.perf_counter() - time_start) * 1000.0
+        if result:
+            samples.append(time_diff)
+        else:
+            errors += 1
+    return samples, errors
+
+
+def summarize(name, samples, errors):
+    summary = {
+        "name": name,
+        "count": len(samples),
+        "errors": errors,
+        "mean_ms": statistics.mean(samples) if samples else 0.0,
+        "p50_ms": percentile(samples, 50),
+        "p95_ms": percentile(samples, 95),
+        "max_ms": max(samples) if samples else 0.0,
+    }
+    logging.info("%(name)s: n=%(count)d err=%(errors)d mean=%(mean_ms).1fms "
+                 "p50=%(p50_ms).1fms p95=%(p95_ms).1fms max=%(max_ms).1fms" % summary)
+    return summary
+
+
+def bench_config(device, iterations=20):
+    """
+    measure the GET /api/config latency and the heap state around the run
+    """
+    heap_before = heap_snapshot(device)
+    samples, errors = time_call(device.get_config, iterations)
+    heap_after = heap_snapshot(device)
+
+    summary = summarize("%s GET /api/config" % device.hostname, samples, errors)
+    summary["heap_before"] = heap_before
+    summary["heap_after"] = heap_after
+    logging.info("%s heap before: %s" % (device.hostname, heap_before))
+    logging.info("%s heap after: %s" % (device.hostname, heap_after))
+    return summary
+
+
+def bench_endpoints(device, iterations=20):
+    """
+    measure the latency of the json endpoints and the heap state after each endpoint run,
+    the peak heap of a single response is logged by the device as a DEBUG line:
+    "[Webserver] /api/... peak heap: ..."
+    """
+    endpoints = {
+        "GET /api/version": device.get_version,
+        "GET /api/systeminfo": device.get_system_info,
+        "GET /api/config": device.get_config,
+        "GET /api/get": lambda: device.get_relay(1),
+    }
+
+    summaries = []
+    for name, cb in endpoints.items():
+        samples, errors = time_call(cb, iterations)
+        summary = summarize("%s %s" % (device.hostname, name), samples, errors)
+        summary["heap_after"] = heap_snapshot(device)
+        logging.info("%s heap after: %s" % (device.hostname, summary["heap_after"]))
+        summaries.append(summary)
+    return summaries
+
+
+def tls_handshake(host, context, session=None, port=443):
+    """
+    open a connection, do the handshake and close it again
+    returns (handshake time in ms, session, reused) or None on failure
+    """
+    try:
+        with socket.create_connection((host, port), timeout=15) as sock:
+            time_start = time.perf_counter()
+            with context.wrap_socket(sock, server_hostname=host, session=session) as tls_sock:
+                time_diff = (time.perf_counter() - time_start) * 1000.0
+                return time_diff, tls_sock.session, tls_sock.session_reused
+    except (OSError, ssl.SSLError) as e:
+        logging.error("%s: handshake failed: %s" % (host, e))
+        return None
+
+
+def bench_tls(device, iterations=20):
+    """
+    compare a full handshake against a resumed one (session id),
+    only the handshake itself is timed, the tcp connect is excluded
+    """
+    host = "%s.local" % device.hostname.lower()
+    context = tls_context()
+
+    full_samples = []
+    full_errors = 0
+    for _ in range(iterations):
+        result = tls_handshake(host, context)
+        if result:
+            full_samples.append(result[0])
+        else:
+            full_errors += 1
+
+    resumed_samples = []
+    resumed_errors = 0
+    session = None
+    result = tls_handshake(host, context)
+    if result:
+        session = result[1]
+    for _ in range(iterations):
+        result = tls_handshake(host, context, session)
+        if result and result[2]:
+            resumed_samples.append(result[0])
+            session = result[1]
+        else:
+            resumed_errors += 1  # failed or fell back to a full handshake
+
+    summaries = [
+        summarize("%s TLS full handshake" % device.hostname, full_samples, full_errors),
+        summarize("%s TLS resumed handshake" % device.hostname, resumed_samples, resumed_errors),
+    ]
+    return summaries
+
+
+def bench_keepalive(device, iterations=20):
+    """
+    compare a burst of GET /api/get calls over one kept alive connection
+    against the same burst with a new connection (and handshake) per call
+    """
+    def new_connection():
+        device.session.close()
+        return device.get_relay(1)
+
+    summaries = [
+        summarize("%s GET /api/get new connection" % device.hostname, *time_call(new_connection, iterations)),
+        summarize("%s GET /api/get keep-alive" % device.hostname, *time_call(lambda: device.get_relay(1), iterations)),
+    ]
+    return summaries
+
+
+def bench_udp(device, iterations=20):
+    """
+    toggle relay 1 over https and over the udp control channel,
+    an even amount of iterations leaves the relay in its original state
+    """
+    iterations += iterations % 2
+    control = UdpControl(device.hostname, device.www_user, device.www_pass)
+    control.get_state()  # resolve the hostname and sync the nonce
+
+    summaries = [
+        summarize("%s POST /api/set toggle" % device.hostname, *time_call(lambda: device.set_relay(1), iterations)),
+        summarize("%s UDP toggle" % device.hostname,
+                  *time_call(lambda: control.toggle_relays(0x01) is not None, iterations)),
+    ]
+    control.close()
+    return summaries
@@ -89,9 +89,9 @@ class SetupHelper:
         self.www_user = config["security"]["www_user"]
         self.www_pass = config["security"]["www_pass"]
 
-    def add(self, device):
+    def add(self, device, base_url=None):
         self.devices[device] = SmartHueApi(
-            device, self.www_user, self.www_pass)
+            device, self.www_user, self.www_pass, base_url)
         return self
 
     def get(self, device):
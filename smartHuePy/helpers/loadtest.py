@@ -0,0 +1,196 @@
+import asyncio
+import concurrent.futures
+import logging
+import random
+import statistics
+import time
+
+import requests
+
+from smartHuePy.helpers.benchmark import percentile
+from smartHuePy.helpers.smarthueapi import SmartHueApi
+
+# request mix name: api call, relay is the relay under test
+OPERATIONS = {
+    "get": lambda device, relay: device.get_relay(relay),
+    "set": lambda device, relay: device.set_relay(relay),  # toggle
+    "systeminfo": lambda device, relay: device.get_system_info(),
+    "version": lambda device, relay: device.get_version(),
+    "config": lambda device, relay: device.get_config(),
+}
+
+DEFAULT_MIX = "get=6,set=2,systeminfo=1"
+
+
+def parse_mix(text):
+    """
+    "get=6,set=2,systeminfo=1" -> {"get": 6, "set": 2, "systeminfo": 1}
+    """
+    mix = {}
+    for part in text.split(","):
+        name, _, weight = part.partition("=")
+        name = name.strip()
+        if name not in OPERATIONS:
+            raise ValueError("unknown operation: %s (%s)" % (name, ", ".join(sorted(OPERATIONS))))
+        mix[name] = float(weight) if weight else 1.0
+    if not any(mix.values()):
+        raise ValueError("empty request mix: %s" % text)
+    return mix
+
+
+def heap_trend(samples):
+    """
+    samples: list of (seconds since start, free_heap, max_free_block_size)
+    the slope is a least squares fit of free_heap, negative means the heap shrinks
+    """
+    if not samples:
+        return None
+    times = [sample[0] for sample in samples]
+    heaps = [sample[1] for sample in samples]
+    slope = 0.0
+    if len(samples) > 1 and max(times) > min(times):
+        mean_time = statistics.mean(times)
+        mean_heap = statistics.mean(heaps)
+        slope = sum((t - mean_time) * (h - mean_heap) for t, h in zip(times, heaps)) / \
+            sum((t - mean_time) ** 2 for t in times)
+    return {
+        "samples": len(samples),
+        "free_heap_first": heaps[0],
+        "free_heap_last": heaps[-1],
+        "free_heap_min": min(heaps),
+        "free_heap_slope_per_min": slope * 60.0,
+        "max_free_block_size_min": min(sample[2] for sample in samples),
+    }
+
+
+def summarize_samples(name, elapsed, samples, errors, timeouts):
+    total = len(samples) + errors + timeouts
+    summary = {
+        "name": name,
+        "requests": total,
+        "count": len(samples),
+        "errors": errors,
+        "timeouts": timeouts,
+        "error_rate": errors / total if total else 0.0,
+        "timeout_rate": timeouts / total if total else 0.0,
+        "throughput_rps": len(samples) / elapsed if elapsed else 0.0,
+        "mean_ms": statistics.mean(samples) if samples else 0.0,
+        "p50_ms": percentile(samples, 50),
+        "p95_ms": percentile(samples, 95),
+        "p99_ms": percentile(samples, 99),
+        "max_ms": max(samples) if samples else 0.0,
+    }
+    logging.info("%(name)s: n=%(requests)d ok=%(count)d err=%(errors)d timeout=%(timeouts)d "
+                 "%(throughput_rps).1freq/s p50=%(p50_ms).1fms p95=%(p95_ms).1fms p99=%(p99_ms).1fms "
+                 "max=%(max_ms).1fms" % summary)
+    return summary
+
+
+class LoadTest:
+    """
+    concurrent clients against one device, every client gets its own copy of the SmartHueApi (and connection),
+    the blocking api calls run in a thread pool so asyncio only schedules them
+
+    ussage e.g.:
+    load_test = LoadTest(setup.get(name), concurrency=4, mix=parse_mix("get=6,set=2"), duration=30)
+    report = asyncio.run(load_test.run())
+    """
+
+    def __init__(self, device, concurrency=4, mix=None, duration=30.0, max_requests=None,
+                 timeout=5.0, heap_interval=2.0, relay=1, seed=None):
+        self.device = device
+        self.concurrency = concurrency
+        self.mix = mix or parse_mix(DEFAULT_MIX)
+        self.duration = duration
+        self.max_requests = max_requests  # total budget, overrules the duration
+        self.timeout = timeout
+        self.heap_interval = heap_interval
+        self.relay = relay
+        self.random = random.Random(seed)
+
+        self.samples = {name: [] for name in self.mix}
+        self.errors = {name: 0 for name in self.mix}
+        self.timeouts = {name: 0 for name in self.mix}
+        self.heap_samples = []
+        self.issued = 0
+
+    def _device(self):
+        device = SmartHueApi(self.device.hostname, self.device.www_user, self.device.www_pass, self.device.base_url,
+                             self.device.encoding)
+        device.timeout = self.timeout
+        return device
+
+    def _next_operation(self):
+        if self.max_requests is not None:
+            if self.issued >= self.max_requests:
+                return None
+        elif time.perf_counter() >= self.deadline:
+            return None
+        self.issued += 1
+        names = list(self.mix)
+        return self.random.choices(names, weights=[self.mix[name] for name in names])[0]
+
+    async def _client(self, executor):
+        loop = asyncio.get_running_loop()
+        device = self._device()
+        while True:
+            name = self._next_operation()
+            if not name:
+                break
+
+            time_start = time.perf_counter()
+            result = await loop.run_in_executor(executor, OPERATIONS[name], device, self.relay)
+            time_diff = (time.perf_counter() - time_start) * 1000.0
+            if result:
+                self.samples[name].append(time_diff)
+            elif isinstance(device.last_error, requests.Timeout):
+                self.timeouts[name] += 1
+            else:
+                self.errors[name] += 1
+        device.session.close()
+
+    async def _heap_monitor(self, executor, done):
+        loop = asyncio.get_running_loop()
+        device = self._device()
+        while True:
+            system_info = await loop.run_in_executor(executor, device.get_system_info)
+            # the device serves one connection at a time, a kept alive monitor would starve the clients
+            device.session.close()
+            if system_info:
+                self.heap_samples.append((time.perf_counter() - self.time_start,
+                                          system_info.get("free_heap", 0),
+                                          system_info.get("max_free_block_size", 0)))
+            try:
+                await asyncio.wait_for(asyncio.shield(done), self.heap_interval)
+                break
+            except asyncio.TimeoutError:
+                pass
+
+    async def run(self):
+        self.time_start = time.perf_counter()
+        self.deadline = self.time_start + self.duration
+        done = asyncio.get_running_loop().create_future()
+
+        # one extra thread for the heap monitor, its calls are not part of the results
+        with concurrent.futures.ThreadPoolExecutor(max_workers=self.concurrency + 1) as executor:
+            monitor = asyncio.ensure_future(self._heap_monitor(executor, done))
+            await asyncio.gather(*[self._client(executor) for _ in range(self.concurrency)])
+            elapsed = time.perf_counter() - self.time_start
+            done.set_result(True)
+            await monitor
+
+        name = self.device.hostname
+        all_samples = [sample for samples in self.samples.values() for sample in samples]
+        report = summarize_samples("%s total (concurrency %d)" % (name, self.concurrency), elapsed, all_samples,
+                                   sum(self.errors.values()), sum(self.timeouts.values()))
+        report["elapsed_s"] = elapsed
+        report["concurrency"] = self.concurrency
+        report["mix"] = self.mix
+        report["operations"] = [
+            summarize_samples("%s %s" % (name, operation), elapsed, self.samples[operation],
+                              self.errors[operation], self.timeouts[operation])
+            for operation in self.mix
+        ]
+        report["heap"] = heap_trend(self.heap_samples)
+        logging.info("%s heap: %s" % (name, report["heap"]))
+        return report
@@ -1,3 +1,4 @@
+import cbor2
 import requests
 import json
 import ssl
@@ -6,14 +7,51 @@ import urllib3
 urllib3.disable_warnings(
     urllib3.exceptions.InsecureRequestWarning)
 
+# the device has an EC certificate and no aes hardware, chacha20 is the cheapest bulk cipher for it
+TLS_CIPHERS = "ECDHE-ECDSA-CHACHA20-POLY1305:ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-ECDSA-AES128-SHA256"
+
+
+def tls_context():
+    context = ssl.SSLContext(ssl.PROTOCOL_TLS_CLIENT)
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+    context.maximum_version = ssl.TLSVersion.TLSv1_2  # session id resumption, bearssl has no tls 1.3
+    context.set_ciphers(TLS_CIPHERS)
+    return context
+
+
+class TlsAdapter(requests.adapters.HTTPAdapter):
+    """
+    offers the TLS_CIPHERS only, requests itself has no option for the cipher suites
+    """
+
+    def init_poolmanager(self, *args, **kwargs):
+        kwargs["ssl_context"] = tls_context()
+        return super().init_poolmanager(*args, **kwargs)
+
 
 class SmartHueApi:
-    def __init__(self, name, www_user, www_pass):
+    def __init__(self, name, www_user, www_pass, base_url=None, encoding="json"):
         self.hostname = name
         self.www_user = www_user
         self.www_pass = www_pass
+        # e.g. "http://localhost:8443" for the native simulator
+        self.base_url = base_url or "https://%s.local" % name.lower()
+        self.timeout = 15
+        # "json" or "cbor", the body of the requests and the accepted responses
+        self.encoding = encoding
+        # outcome of the last api call, the calls themselves only return False on failure
+        self.last_status = None
+        self.last_error = None
+        self.last_headers = {}
         self.ssl_cert = None
         self.ssl_key = None
+        # one session per device, the tls connection is reused between api calls
+        self.session = requests.Session()
+        self.session.auth = requests.auth.HTTPBasicAuth(
+            self.www_user, self.www_pass)
+        self.session.verify = False
+        self.session.mount("https://", TlsAdapter())
 
     def setSSLContext(self, certfile, keyfile):
         self.ssl_cert = certfile
@@ -32,7 +70,12 @@ class SmartHueApi:
     def get_version(self):
         return self._request_api("/api/version", "GET")
 
-    def get_system_info(self):
+    def get_system_info(self, fields=None):
+        """
+        fields: e.g. "free_heap,rssi" or "dynamic", all fields by default
+        """
+        if fields:
+            return self._request_api("/api/systeminfo?fields=%s" % fields, "GET")
         return self._request_api("/api/systeminfo", "GET")
 
     def get_config(self):
@@ -47,33 +90,80 @@ class SmartHueApi:
             body["value"] = value
         return self._request_api("/api/set", "POST", body)
 
+    def set_relays(self, operations):
+        """
+        switch several relays in one step
+        operations: list of {"relay": 1, "value": True} (set) or {"relay": 1} (toggle)
+        returns the resulting state of every relay
+        """
+        return self._request_api("/api/set", "POST", operations)
+
+    def get_state(self, etag=None):
+        """
+        relays, firmware version and health in one call
+        etag: the ETag of an earlier response, returns True instead of the state if nothing changed (304)
+        the ETag of the response is in self.last_headers["ETag"]
+        """
+        headers = {"If-None-Match": etag} if etag else None
+        return self._request_api("/api/state", "GET", headers=headers)
+
     def get_relay(self, relay):
         return self._request_api("/api/get?relay=%d" % relay, "GET")
 
     def get_ota(self):
         return self._request_api("/api/ota", "GET")
 
-    def _request_api(self, path, method="GET", body=None):
-        uri = "https://%s.local%s" % (self.hostname.lower(), path)
+    def get_metrics(self):
+        """
+        Prometheus text exposition format, returned as text
+        """
+        return self._request_api("/api/metrics", "GET", text=True)
+
+    def get_profile(self):
+        return self._request_api("/api/profile", "GET")
+
+    def reset_profile(self):
+        return self._request_api("/api/profile/reset", "GET")
+
+    def _request_api(self, path, method="GET", body=None, headers=None, text=False):
+        uri = "%s%s" % (self.base_url, path)
         request_args = {}
-        request_args["timeout"] = 15
-        request_args["auth"] = requests.auth.HTTPBasicAuth(
-            self.www_user, self.www_pass)
-        request_args["verify"] = False
+        request_args["timeout"] = self.timeout
+        self.last_status = None
+        self.last_error = None
+        self.last_headers = {}
+        request_headers = dict(headers or {})
+        if self.encoding == "cbor":
+            request_headers["Accept"] = "application/cbor"
         if body:
-            request_args["data"] = json.dumps(body)
+            if self.encoding == "cbor":
+                request_args["data"] = cbor2.dumps(body)
+                request_headers["Content-Type"] = "application/cbor"
+            else:
+                request_args["data"] = json.dumps(body)
+        if request_headers:
+            request_args["headers"] = request_headers
 
         try:
             if method == "GET":
-                r = requests.get(uri, **request_args)
+                r = self.session.get(uri, **request_args)
             if method == "POST":
-                r = requests.post(uri, **request_args)
-        except:
-            # not sure if the device is up
-            pass
+                r = self.session.post(uri, **request_args)
+            self.last_status = r.status_code
+            self.last_headers = r.headers
+        except Exception as e:
+            # not sure if the device is up, start over with a fresh connection
+            self.last_error = e
+            self.session.close()
         finally:
+            if "r" in locals() and r.status_code == 304:
+                return True  # not modified, only for a conditional request
             if "r" in locals() and r.status_code == 200:
+                if text:
+                    return r.text
                 try:
+                    if r.headers.get("Content-Type", "").startswith("application/cbor"):
+                        return cbor2.loads(r.content)
                     return r.json()
                 except:
                     # not all api calls do return a json
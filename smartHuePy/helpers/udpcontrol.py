@@ -0,0 +1,113 @@
+import hashlib
+import hmac
+import socket
+import struct
+import time
+
+OP_OFF = 0
+OP_ON = 1
+OP_TOGGLE = 2
+OP_STATE = 3
+
+STATUS_OK = 0
+STATUS_NONCE = 1
+STATUS_REPLAY = 2
+
+VERSION = 1
+MAC_SIZE = 16
+
+# magic, version, code, mask, reserved, nonce, seq, timestamp (little endian, see src/UdpControl/UdpControl.h)
+HEADER = struct.Struct("<2sBBHHIII")
+
+
+class UdpControl:
+    """
+    client for the authenticated udp relay control channel
+    relays are given as a bit mask, bit 0 is relay 1
+    """
+
+    def __init__(self, name, www_user, www_pass, port=4210, timeout=1.0, retries=3, host=None):
+        self.hostname = name
+        # e.g. "localhost" for the native simulator, defaults to the mdns name
+        self.host = host
+        self.port = port
+        self.retries = retries
+        self.key = hmac.new(www_pass.encode(), b"SmartHue-udp:" + www_user.encode(), hashlib.sha256).digest()
+        self.nonce = 0
+        self.seq = 0
+        self.address = None
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(timeout)
+
+    def close(self):
+        self.sock.close()
+
+    def set_relays(self, mask, value):
+        return self._request(OP_ON if value else OP_OFF, mask)
+
+    def toggle_relays(self, mask):
+        return self._request(OP_TOGGLE, mask)
+
+    def get_state(self):
+        return self._request(OP_STATE, 0)
+
+    def _mac(self, header):
+        return hmac.new(self.key, header, hashlib.sha256).digest()[:MAC_SIZE]
+
+    def _request(self, op, mask):
+        """
+        returns the relay state mask, or None if the device didn't answer
+        a lost request or ack is resent as the same frame, the device applies a sequence number only once
+        a stale nonce or sequence number is resynced from the ack and the request is sent again
+        """
+        if not self.address:
+            # resolve once, mdns resolution is slower than the request itself
+            host = self.host or "%s.local" % self.hostname.lower()
+            self.address = (socket.gethostbyname(host), self.port)
+
+        frame = None
+        for _ in range(self.retries):
+            if not frame:
+                self.seq += 1
+                header = HEADER.pack(b"SQ", VERSION, op, mask, 0, self.nonce, self.seq,
+                                     int(time.time() * 1000) & 0xFFFFFFFF)
+                frame = header + self._mac(header)
+            self.sock.sendto(frame, self.address)
+
+            ack = self._receive()
+            if not ack:
+                continue
+            status, state, nonce, seq = ack
+
+            if status == STATUS_OK:
+                return state
+            if status == STATUS_REPLAY and seq == self.seq:
+                return state  # the request was applied before, only its ack got lost
+            self.nonce = nonce
+            self.seq = seq
+            frame = None
+        return None
+
+    def _receive(self):
+        """
+        returns (status, state, nonce, seq) of the ack of the current sequence number, or None on a timeout
+        invalid acks and late acks of earlier requests are skipped
+        """
+        while True:
+            try:
+                data, _ = self.sock.recvfrom(64)
+            except socket.timeout:
+                return None
+            if len(data) != HEADER.size + MAC_SIZE:
+                continue
+
+            header, mac = data[:HEADER.size], data[HEADER.size:]
+            if not hmac.compare_digest(mac, self._mac(header)):
+                continue
+            magic, version, status, state, _, nonce, seq, _ = HEADER.unpack(header)
+            if magic != b"SA" or version != VERSION:
+                continue
+
+            if nonce == self.nonce and seq < self.seq:
+                continue  # late ack of an earlier request, or of a resent frame
+            return status, state, nonce, seq
@@ -31,6 +31,39 @@ void digitalWrite(const uint8_t (&pin)[size], uint8_t val)
     }
 }
 
+/**
+ *
+ * @tparam T: any struct with a pin member
+ * @tparam size: automatic filled
+ * @param pins: array of pin configs
+ * @param mode: INPUT or OUTPUT
+ */
+template <typename T, size_t size>
+void pinMode(const T (&pins)[size], uint8_t mode)
+{
+    for (size_t i = 0; i < size; ++i) {
+        pinMode(pins[i].pin, mode);
+    }
+}
+
+/**
+ *
+ * @tparam T: any struct with a pin member
+ * @tparam size: automatic filled
+ * @param pins: array of pin configs
+ * @param level: member that holds the level of each pin
+ *
+ * ussage e.g.:
+ * digitalWrite(board::relays, &RelayConfig::powerOnLevel);
+ */
+template <typename T, size_t size>
+void digitalWrite(const T (&pins)[size], uint8_t T::*level)
+{
+    for (size_t i = 0; i < size; ++i) {
+        digitalWrite(pins[i].pin, pins[i].*level);
+    }
+}
+
 /**
  * 
  * The doWhileLoopDelay function guarantees a minimum of 1 execution
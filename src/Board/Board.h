@@ -0,0 +1,58 @@
+#pragma once
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <Arduino.h>
+
+/**
+ * Relay board profile: pin, levels and power-on state per relay.
+ *
+ * Only the 2 channel electrodragon board is in the table. A profile for
+ * another board goes in an #if block with its own build flag, the pins
+ * have to come from the schematic of that board. GPIO 0, 2 and 15 are
+ * boot strapping pins (0 and 2 high, 15 low at reset), a relay driver on
+ * one of them can keep the module from booting.
+ *
+ * ussage e.g.:
+ * const RelayConfig* relay = board::relay(1);
+ * if (relay) digitalWrite(relay->pin, board::level(*relay, true));
+ */
+struct RelayConfig {
+    uint8_t pin;
+    uint8_t activeLevel; // level that closes the relay
+    uint8_t powerOnLevel; // level forced at boot
+    uint8_t offLevel; // level forced before a reboot
+};
+
+namespace board {
+
+constexpr const char* NAME = "electrodragon-2ch";
+constexpr RelayConfig relays[] = {
+    { 12 /* D6 */, HIGH, HIGH, LOW },
+    { 13 /* D7 */, HIGH, HIGH, LOW },
+};
+
+constexpr uint8_t RELAY_COUNT = sizeof(relays) / sizeof(relays[0]);
+
+/**
+ * @param id: relay id, starts at 1
+ * @return nullptr for an unknown relay
+ */
+inline const RelayConfig* relay(uint8_t id)
+{
+    return id && id <= RELAY_COUNT ? &relays[id - 1] : nullptr;
+}
+
+inline bool isOn(const RelayConfig& relay)
+{
+    return digitalRead(relay.pin) == relay.activeLevel;
+}
+
+inline uint8_t level(const RelayConfig& relay, bool on)
+{
+    return on ? relay.activeLevel : !relay.activeLevel;
+}
+
+}
+
+#endif
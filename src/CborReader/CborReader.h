@@ -0,0 +1,296 @@
+#ifndef CborReader_h
+#define CborReader_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <cmath>
+
+#ifndef CBOR_READER_MAX_DEPTH
+#define CBOR_READER_MAX_DEPTH 4
+#endif
+
+/**
+ * Decode a CBOR (RFC 8949) request body into an ArduinoJson tree, so the
+ * handlers validate it exactly like a json body.
+ *
+ * Only the json data model is accepted: (un)signed integers, text strings
+ * (map keys included), arrays, maps, booleans, null and floats. Byte
+ * strings, tags and anything nested deeper than CBOR_READER_MAX_DEPTH are
+ * rejected, as is trailing data.
+ *
+ * Like ArduinoJson with a char*, a writable input is parsed in place: a
+ * text string is moved over its own head and terminated there, the tree
+ * points into the input. A const input is copied into the JsonBuffer.
+ *
+ * ussage e.g.:
+ * DynamicJsonBuffer jsonBuffer;
+ * JsonVariant root = CborReader::parse(jsonBuffer, body, length);
+ * if (!root.success()) { ... }
+ */
+class CborReader {
+public:
+    template <class JsonBuffer>
+    static JsonVariant parse(JsonBuffer& jsonBuffer, const uint8_t* data, size_t length)
+    {
+        CborReader reader(data, length, nullptr);
+        return reader.read(jsonBuffer);
+    }
+
+    template <class JsonBuffer>
+    static JsonVariant parse(JsonBuffer& jsonBuffer, uint8_t* data, size_t length)
+    {
+        CborReader reader(data, length, data);
+        return reader.read(jsonBuffer);
+    }
+
+private:
+    enum : uint8_t {
+        MAJOR_UNSIGNED = 0,
+        MAJOR_NEGATIVE = 1,
+        MAJOR_TEXT = 3,
+        MAJOR_ARRAY = 4,
+        MAJOR_MAP = 5,
+        MAJOR_SIMPLE = 7,
+        INDEFINITE = 31,
+        BREAK = 0xff,
+    };
+
+    CborReader(const uint8_t* data, size_t length, uint8_t* writable)
+        : m_data(data)
+        , m_writable(writable)
+        , m_length(length)
+        , m_position(0)
+    {
+    }
+
+    template <class JsonBuffer>
+    JsonVariant read(JsonBuffer& jsonBuffer)
+    {
+        JsonVariant value;
+        if (!readValue(jsonBuffer, value, 0) || m_position != m_length) {
+            return JsonVariant();
+        }
+        return value;
+    }
+
+    bool readByte(uint8_t& byte)
+    {
+        if (m_position >= m_length) {
+            return false;
+        }
+        byte = m_data[m_position++];
+        return true;
+    }
+
+    bool readUInt(size_t size, uint64_t& value)
+    {
+        if (m_length - m_position < size) {
+            return false;
+        }
+        value = 0;
+        while (size--) {
+            value = (value << 8) | m_data[m_position++];
+        }
+        return true;
+    }
+
+    /**
+     * argument of the head, indefinite: length 31 (only for arrays and maps)
+     */
+    bool readArgument(uint8_t info, uint64_t& value, bool& indefinite)
+    {
+        indefinite = false;
+        if (info < 24) {
+            value = info;
+            return true;
+        }
+        switch (info) {
+        case 24:
+            return readUInt(1, value);
+        case 25:
+            return readUInt(2, value);
+        case 26:
+            return readUInt(4, value);
+        case 27:
+            return readUInt(8, value);
+        case INDEFINITE:
+            indefinite = true;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool isBreak()
+    {
+        if (m_position < m_length && m_data[m_position] == BREAK) {
+            m_position++;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * head: position of the head of the text string, in place it ends up there
+     */
+    template <class JsonBuffer>
+    const char* readText(JsonBuffer& jsonBuffer, size_t head, uint64_t length)
+    {
+        if (length > m_length - m_position) {
+            return nullptr;
+        }
+        char* text = m_writable ? (char*)m_writable + head : (char*)jsonBuffer.alloc(length + 1);
+        if (!text) {
+            return nullptr;
+        }
+        memmove(text, m_data + m_position, length);
+        text[length] = '\0';
+        m_position += length;
+        return text;
+    }
+
+    template <class JsonBuffer>
+    bool readValue(JsonBuffer& jsonBuffer, JsonVariant& value, uint8_t depth)
+    {
+        size_t start = m_position;
+        uint8_t head;
+        if (!readByte(head)) {
+            return false;
+        }
+        uint8_t major = head >> 5;
+        uint8_t info = head & 0x1f;
+
+        if (major == MAJOR_SIMPLE) {
+            uint64_t bits;
+            switch (info) {
+            case 20:
+                value = false;
+                return true;
+            case 21:
+                value = true;
+                return true;
+            case 22:
+                value = (const char*)nullptr;
+                return true;
+            case 25: {
+                // half float, RFC 8949 appendix D
+                if (!readUInt(2, bits)) {
+                    return false;
+                }
+                int exponent = (bits >> 10) & 0x1f;
+                int mantissa = bits & 0x3ff;
+                double number;
+                if (exponent == 0) {
+                    number = ldexp(mantissa, -24);
+                } else if (exponent != 31) {
+                    number = ldexp(mantissa + 1024, exponent - 25);
+                } else {
+                    number = mantissa ? NAN : INFINITY;
+                }
+                value = bits & 0x8000 ? -number : number;
+                return true;
+            }
+            case 26: {
+                float number;
+                uint32_t bits32;
+                if (!readUInt(4, bits)) {
+                    return false;
+                }
+                bits32 = bits;
+                memcpy(&number, &bits32, sizeof(number));
+                value = number;
+                return true;
+            }
+            case 27: {
+                double number;
+                if (!readUInt(8, bits)) {
+                    return false;
+                }
+                memcpy(&number, &bits, sizeof(number));
+                value = number;
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        uint64_t argument;
+        bool indefinite;
+        if (!readArgument(info, argument, indefinite)) {
+            return false;
+        }
+        if (indefinite && major != MAJOR_ARRAY && major != MAJOR_MAP) {
+            return false;
+        }
+
+        switch (major) {
+        case MAJOR_UNSIGNED:
+            if (argument > (uint64_t)LONG_MAX) {
+                return false;
+            }
+            value = (long)argument;
+            return true;
+        case MAJOR_NEGATIVE:
+            if (argument > (uint64_t)LONG_MAX) {
+                return false;
+            }
+            value = -1 - (long)argument;
+            return true;
+        case MAJOR_TEXT: {
+            const char* text = readText(jsonBuffer, start, argument);
+            if (!text) {
+                return false;
+            }
+            value = text;
+            return true;
+        }
+        case MAJOR_ARRAY: {
+            if (depth == CBOR_READER_MAX_DEPTH) {
+                return false;
+            }
+            JsonArray& array = jsonBuffer.createArray();
+            for (uint64_t i = 0; indefinite ? !isBreak() : i < argument; i++) {
+                JsonVariant item;
+                if (!readValue(jsonBuffer, item, depth + 1) || !array.add(item)) {
+                    return false;
+                }
+            }
+            value = array;
+            return true;
+        }
+        case MAJOR_MAP: {
+            if (depth == CBOR_READER_MAX_DEPTH) {
+                return false;
+            }
+            JsonObject& object = jsonBuffer.createObject();
+            for (uint64_t i = 0; indefinite ? !isBreak() : i < argument; i++) {
+                size_t keyStart = m_position;
+                uint8_t keyHead;
+                uint64_t keyLength;
+                bool keyIndefinite;
+                if (!readByte(keyHead) || keyHead >> 5 != MAJOR_TEXT || !readArgument(keyHead & 0x1f, keyLength, keyIndefinite)
+                    || keyIndefinite) {
+                    return false;
+                }
+                const char* key = readText(jsonBuffer, keyStart, keyLength);
+                JsonVariant item;
+                if (!key || !readValue(jsonBuffer, item, depth + 1) || !object.set(key, item)) {
+                    return false;
+                }
+            }
+            value = object;
+            return true;
+        }
+        default:
+            return false; // byte strings and tags
+        }
+    }
+
+    const uint8_t* m_data;
+    uint8_t* m_writable; // m_data if parsed in place
+    size_t m_length;
+    size_t m_position;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef CborWriter_h
+#define CborWriter_h
+
+#include <Arduino.h>
+#include <type_traits>
+
+#define CBOR_CONTENT_TYPE "application/cbor"
+
+/**
+ * Streaming CBOR (RFC 8949) writer with the interface of JsonWriter, so a
+ * response body can be written once for both encodings.
+ *
+ * Objects and arrays use the indefinite length encoding, the writer never
+ * needs to know the amount of members up front and keeps no state at all.
+ *
+ * ussage e.g.:
+ * CborWriter cbor(response);
+ * cbor.beginObject();
+ * cbor.set(F("free_heap"), ESP.getFreeHeap());
+ * cbor.endObject();
+ */
+class CborWriter {
+public:
+    CborWriter(Print& out)
+        : m_out(out)
+    {
+    }
+
+    CborWriter& beginObject()
+    {
+        return open(MAJOR_MAP);
+    }
+
+    template <typename Key>
+    CborWriter& beginObject(const Key& key)
+    {
+        writeValue(key);
+        return open(MAJOR_MAP);
+    }
+
+    CborWriter& endObject()
+    {
+        return close();
+    }
+
+    CborWriter& beginArray()
+    {
+        return open(MAJOR_ARRAY);
+    }
+
+    template <typename Key>
+    CborWriter& beginArray(const Key& key)
+    {
+        writeValue(key);
+        return open(MAJOR_ARRAY);
+    }
+
+    CborWriter& endArray()
+    {
+        return close();
+    }
+
+    /**
+     * write a key, value pair into the current map
+     */
+    template <typename Key, typename Value>
+    CborWriter& set(const Key& key, const Value& value)
+    {
+        writeValue(key);
+        writeValue(value);
+        return *this;
+    }
+
+    /**
+     * write a value into the current array
+     */
+    template <typename Value>
+    CborWriter& add(const Value& value)
+    {
+        writeValue(value);
+        return *this;
+    }
+
+private:
+    enum : uint8_t {
+        MAJOR_UNSIGNED = 0 << 5,
+        MAJOR_NEGATIVE = 1 << 5,
+        MAJOR_TEXT = 3 << 5,
+        MAJOR_ARRAY = 4 << 5,
+        MAJOR_MAP = 5 << 5,
+        INDEFINITE = 31,
+        FALSE_VALUE = 0xf4,
+        TRUE_VALUE = 0xf5,
+        NULL_VALUE = 0xf6,
+        FLOAT32 = 0xfa,
+        FLOAT64 = 0xfb,
+        BREAK = 0xff,
+    };
+
+    CborWriter& open(uint8_t major)
+    {
+        m_out.write((uint8_t)(major | INDEFINITE));
+        return *this;
+    }
+
+    CborWriter& close()
+    {
+        m_out.write((uint8_t)BREAK);
+        return *this;
+    }
+
+    /**
+     * major type with its argument in the shortest form
+     */
+    void writeHead(uint8_t major, uint64_t value)
+    {
+        uint8_t buffer[9];
+        size_t length;
+        if (value < 24) {
+            buffer[0] = major | (uint8_t)value;
+            length = 1;
+        } else if (value <= 0xff) {
+            buffer[0] = major | 24;
+            length = 2;
+        } else if (value <= 0xffff) {
+            buffer[0] = major | 25;
+            length = 3;
+        } else if (value <= 0xffffffffULL) {
+            buffer[0] = major | 26;
+            length = 5;
+        } else {
+            buffer[0] = major | 27;
+            length = 9;
+        }
+        for (size_t i = length - 1; i > 0; i--) {
+            buffer[i] = value & 0xff;
+            value >>= 8;
+        }
+        m_out.write(buffer, length);
+    }
+
+    void writeValue(bool value)
+    {
+        m_out.write((uint8_t)(value ? TRUE_VALUE : FALSE_VALUE));
+    }
+
+    void writeValue(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint8_t buffer[5] = { FLOAT32, (uint8_t)(bits >> 24), (uint8_t)(bits >> 16), (uint8_t)(bits >> 8), (uint8_t)bits };
+        m_out.write(buffer, sizeof(buffer));
+    }
+
+    void writeValue(double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        uint8_t buffer[9] = { FLOAT64 };
+        for (size_t i = 8; i > 0; i--) {
+            buffer[i] = bits & 0xff;
+            bits >>= 8;
+        }
+        m_out.write(buffer, sizeof(buffer));
+    }
+
+    template <typename T>
+    typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && !std::is_same<T, bool>::value>::type
+    writeValue(const T& value)
+    {
+        if (std::is_signed<T>::value && (long long)value < 0) {
+            // -1 - n
+            writeHead(MAJOR_NEGATIVE, (uint64_t)(-1 - (long long)value));
+        } else {
+            writeHead(MAJOR_UNSIGNED, (uint64_t)value);
+        }
+    }
+
+    void writeValue(const char* value)
+    {
+        if (!value) {
+            m_out.write((uint8_t)NULL_VALUE);
+            return;
+        }
+        size_t length = strlen(value);
+        writeHead(MAJOR_TEXT, length);
+        m_out.write((const uint8_t*)value, length);
+    }
+
+    void writeValue(const String& value)
+    {
+        writeHead(MAJOR_TEXT, value.length());
+        m_out.write((const uint8_t*)value.c_str(), value.length());
+    }
+
+    void writeValue(const __FlashStringHelper* value)
+    {
+        PGM_P p = reinterpret_cast<PGM_P>(value);
+        writeHead(MAJOR_TEXT, strlen_P(p));
+        for (char c = pgm_read_byte(p); c; c = pgm_read_byte(++p)) {
+            m_out.write((uint8_t)c);
+        }
+    }
+
+    Print& m_out;
+};
+
+#endif
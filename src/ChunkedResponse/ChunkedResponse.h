@@ -0,0 +1,118 @@
+#ifndef ChunkedResponse_h
+#define ChunkedResponse_h
+
+#include <Arduino.h>
+#include <ESP8266WebServer.h>
+
+/**
+ * Print adapter that streams a response body with chunked transfer encoding.
+ *
+ * The body is collected in a fixed size buffer (lives on the stack of the
+ * handler) and handed over to the client each time it fills up, so the
+ * response never exists as a whole in a heap String.
+ *
+ * @tparam Server: ESP8266WebServer(Secure)
+ * @tparam bufferSize: max chunk size
+ *
+ * ussage e.g.:
+ * ChunkedResponse<BearSSL::ESP8266WebServerSecure> response(*server);
+ * response.begin(200, "application/json");
+ * rootObject.printTo(response);
+ * response.end();
+ */
+template <class Server, size_t bufferSize = 256>
+class ChunkedResponse : public Print {
+public:
+    ChunkedResponse(Server& server)
+        : m_server(server)
+        , m_length(0)
+        , m_started(false)
+        , m_heapStart(ESP.getFreeHeap())
+        , m_heapLow(m_heapStart)
+    {
+    }
+
+    ~ChunkedResponse()
+    {
+        end();
+    }
+
+    void begin(int code, const char* contentType)
+    {
+        m_server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        m_server.send(code, contentType, "");
+        m_started = true;
+        sampleHeap();
+    }
+
+    void end()
+    {
+        if (!m_started) {
+            return;
+        }
+        flush();
+        m_server.sendContent(""); // last chunk
+        m_started = false;
+    }
+
+    size_t write(uint8_t c) override
+    {
+        if (m_length == bufferSize) {
+            flush();
+        }
+        m_buffer[m_length++] = (char)c;
+        return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override
+    {
+        size_t written = size;
+        while (size) {
+            if (m_length == bufferSize) {
+                flush();
+            }
+            size_t part = min(size, bufferSize - m_length);
+            memcpy(m_buffer + m_length, buffer, part);
+            m_length += part;
+            buffer += part;
+            size -= part;
+        }
+        return written;
+    }
+
+    void flush()
+    {
+        sampleHeap();
+        if (!m_started || !m_length) {
+            return;
+        }
+        m_server.sendContent(m_buffer, m_length);
+        m_length = 0;
+    }
+
+    /**
+     * peak heap usage (bytes) while this response was built and sent
+     */
+    uint32_t heapUsage() const
+    {
+        return m_heapStart - m_heapLow;
+    }
+
+private:
+    void sampleHeap()
+    {
+        uint32_t freeHeap = ESP.getFreeHeap();
+        if (freeHeap < m_heapLow) {
+            m_heapLow = freeHeap;
+        }
+    }
+
+    Server& m_server;
+    char m_buffer[bufferSize];
+    size_t m_length;
+    bool m_started;
+    uint32_t m_heapStart;
+    uint32_t m_heapLow;
+};
+
+#endif
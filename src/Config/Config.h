@@ -1,167 +1,305 @@
 #ifndef Config_h
 #define Config_h
 
+#include "../RequestArena/RequestArena.h"
 #include "../Storage/Storage.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
 
 #define CONFIG_PATH "/config/system.json"
 
+/**
+ * The config file is parsed once (at construction or on reload) into a typed
+ * in-memory copy. Getters are served from RAM, setters only hit the flash
+ * when a value really changes (write-through).
+ *
+ * Several sections are updated at once with a transaction, everything is
+ * validated before anything is applied and the config is saved only once.
+ *
+ * ussage e.g.:
+ * Config::Transaction transaction = config.begin();
+ * transaction.setWifi("ssid", "pass").setSyslog("10.0.0.2", 514);
+ * uint8_t changed;
+ * if (!transaction.commit(&changed)) {
+ *     Serial.println(transaction.getError());
+ * } else if (changed & Config::SECTION_SYSLOG) {
+ *     setupSyslog();
+ * }
+ */
 class Config {
 public:
+    enum Section : uint8_t {
+        SECTION_NONE = 0,
+        SECTION_WIFI = 1 << 0,
+        SECTION_MQTT = 1 << 1,
+        SECTION_SYSLOG = 1 << 2,
+    };
+
+    struct WifiConfig {
+        String ssid;
+        String pass;
+    };
+
+    struct ServerConfig {
+        String ip;
+        int port;
+    };
+
+    struct Data {
+        String version;
+        WifiConfig wifi;
+        ServerConfig mqtt;
+        ServerConfig syslog;
+    };
+
+    class Transaction {
+    public:
+        Transaction(Config& config)
+            : m_config(config)
+            , m_data(config.getData())
+            , m_error(nullptr)
+        {
+        }
+
+        Transaction& setWifi(const String& ssid, const String& pass)
+        {
+            if (ssid.length() > 32) {
+                fail("wifi ssid too long");
+            } else if (!isValidWifiPass(pass)) {
+                fail("wifi pass must be 8 to 63 characters, 64 hex digits or a wep key");
+            }
+            m_data.wifi.ssid = ssid;
+            m_data.wifi.pass = pass;
+            return *this;
+        }
+
+        Transaction& setMqtt(const String& ip, int port)
+        {
+            validateServer(ip, port, "invalid mqtt server");
+            m_data.mqtt.ip = ip;
+            m_data.mqtt.port = port;
+            return *this;
+        }
+
+        Transaction& setSyslog(const String& ip, int port)
+        {
+            validateServer(ip, port, "invalid syslog server");
+            m_data.syslog.ip = ip;
+            m_data.syslog.port = port;
+            return *this;
+        }
+
+        /**
+         * Apply and save the changes, nothing is applied if any field is invalid.
+         *
+         * @param changed: optional, set to the changed sections (Section flags)
+         * @return false if invalid or if the save failed
+         */
+        bool commit(uint8_t* changed = nullptr)
+        {
+            uint8_t sections = SECTION_NONE;
+            if (!m_error) {
+                const Data& data = m_config.getData();
+                if (m_data.wifi.ssid != data.wifi.ssid || m_data.wifi.pass != data.wifi.pass) {
+                    sections |= SECTION_WIFI;
+                }
+                if (m_data.mqtt.ip != data.mqtt.ip || m_data.mqtt.port != data.mqtt.port) {
+                    sections |= SECTION_MQTT;
+                }
+                if (m_data.syslog.ip != data.syslog.ip || m_data.syslog.port != data.syslog.port) {
+                    sections |= SECTION_SYSLOG;
+                }
+            }
+            if (changed) {
+                *changed = sections;
+            }
+            if (m_error) {
+                return false;
+            }
+            if (sections == SECTION_NONE) {
+                return true; // only write new data!
+            }
+
+            m_config.m_data = m_data;
+            if (!m_config.save()) {
+                fail("config save failed");
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * @return the first validation error, nullptr if none
+         */
+        const char* getError() const
+        {
+            return m_error;
+        }
+
+    private:
+        void fail(const char* error)
+        {
+            if (!m_error) {
+                m_error = error;
+            }
+        }
+
+        /**
+         * empty (open network), a wpa passphrase (8 to 63 characters),
+         * a raw wpa psk (64 hex digits) or a wep key (5 or 13 characters,
+         * the 10 and 26 hex digit keys are within the passphrase range)
+         */
+        static bool isValidWifiPass(const String& pass)
+        {
+            size_t length = pass.length();
+            if (length == 64) {
+                for (size_t i = 0; i < length; i++) {
+                    if (!isHexadecimalDigit(pass[i])) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+            return length == 0 || length == 5 || length == 13 || (length >= 8 && length <= 63);
+        }
+
+        void validateServer(const String& ip, int port, const char* error)
+        {
+            IPAddress ipAddress;
+            if ((ip.length() && !ipAddress.fromString(ip)) || port <= 0 || port > 65535) {
+                fail(error);
+            }
+        }
+
+        Config& m_config;
+        Data m_data;
+        const char* m_error;
+    };
+
     Config(Print *logger = &Serial)
         : m_storage(Storage(CONFIG_PATH, logger))
     {
-        setup();
+        reload();
     }
 
     void reset()
     {
         m_storage.reset();
-        setup();
+        reload();
     }
 
-    String getConfigVersion() const
+    /**
+     * Drop the in-memory copy and read the config file again,
+     * missing keys are filled in with their defaults.
+     */
+    bool reload()
     {
-        DynamicJsonBuffer jsonBuffer;
-        return m_storage.loadJson(jsonBuffer).get<String>("version");
+        bool newConfig = false;
+        RequestArena::Scope scope;
+        ArenaJsonBuffer jsonBuffer;
+        JsonObject& jsonObjectRoot = m_storage.loadJson(jsonBuffer);
+
+        newConfig |= !jsonObjectRoot.containsKey("version");
+        m_data.version = jsonObjectRoot["version"] | "2.0";
+
+        // read wifi config or use the default wifi config
+        JsonObject& jsonobjectWifi = jsonObjectRoot["wifi"];
+        newConfig |= !jsonobjectWifi.containsKey("ssid") || !jsonobjectWifi.containsKey("pass");
+        m_data.wifi.ssid = jsonobjectWifi["ssid"] | "";
+        m_data.wifi.pass = jsonobjectWifi["pass"] | "";
+
+        // read mqtt config or use the default mqtt config
+        JsonObject& jsonobjectMqtt = jsonObjectRoot["mqtt"];
+        newConfig |= !jsonobjectMqtt.containsKey("ip") || !jsonobjectMqtt.containsKey("port");
+        m_data.mqtt.ip = jsonobjectMqtt["ip"] | "";
+        m_data.mqtt.port = jsonobjectMqtt["port"] | 1883;
+
+        // read syslog config or use the default syslog config
+        JsonObject& jsonobjectSyslog = jsonObjectRoot["syslog"];
+        newConfig |= !jsonobjectSyslog.containsKey("ip") || !jsonobjectSyslog.containsKey("port");
+        m_data.syslog.ip = jsonobjectSyslog["ip"] | "";
+        m_data.syslog.port = jsonobjectSyslog["port"] | 514;
+
+        if (newConfig) {
+            return save(); // only write new data!
+        }
+
+        return true;
     }
 
-    void setWifiConfig(const String& ssid, const String& pass)
+    const Data& getData() const
     {
-        String oldSsid, oldPass;
-        getWifiConfig(oldSsid, oldPass);
-        if (oldSsid == ssid && oldPass == pass) {
-            return; // only write new data!
-        }
+        return m_data;
+    }
 
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& jsonObjectRoot = m_storage.loadJson(jsonBuffer);
-        JsonObject& jsonobjectWifi = jsonObjectRoot.get<JsonVariant>("wifi").as<JsonObject>();
-        jsonobjectWifi.set("ssid", ssid);
-        jsonobjectWifi.set("pass", pass);
-        m_storage.writeJson(jsonObjectRoot); // only write new data!
+    Transaction begin()
+    {
+        return Transaction(*this);
     }
 
-    void getWifiConfig(String& ssid, String& pass) const
+    String getConfigVersion() const
     {
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& jsonobjectWifi = m_storage.loadJson(jsonBuffer).get<JsonVariant>("wifi").as<JsonObject>();
-        ssid = jsonobjectWifi.get<String>("ssid");
-        pass = jsonobjectWifi.get<String>("pass");
+        return m_data.version;
     }
 
-    void setMqttConfig(const String& ip, const int& port)
+    bool setWifiConfig(const String& ssid, const String& pass)
     {
-        String oldIp;
-        int oldPort;
-        getMqttConfig(oldIp, oldPort);
-        if (oldIp == ip && oldPort == port) {
-            return; // only write new data!
-        }
+        return begin().setWifi(ssid, pass).commit();
+    }
 
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& jsonObjectRoot = m_storage.loadJson(jsonBuffer);
-        JsonObject& jsonobjectMqtt = jsonObjectRoot.get<JsonVariant>("mqtt").as<JsonObject>();
-        jsonobjectMqtt.set("ip", ip);
-        jsonobjectMqtt.set("port", port);
-        m_storage.writeJson(jsonObjectRoot);
+    void getWifiConfig(String& ssid, String& pass) const
+    {
+        ssid = m_data.wifi.ssid;
+        pass = m_data.wifi.pass;
     }
 
-    void getMqttConfig(String& ip, int& port) const
+    bool setMqttConfig(const String& ip, const int& port)
     {
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& jsonobjectMqtt = m_storage.loadJson(jsonBuffer).get<JsonVariant>("mqtt").as<JsonObject>();
-        ip = jsonobjectMqtt.get<String>("ip");
-        port = jsonobjectMqtt.get<int>("port");
+        return begin().setMqtt(ip, port).commit();
     }
 
-    void setSyslogConfig(const String& ip, const int& port)
+    void getMqttConfig(String& ip, int& port) const
     {
-        String oldIp;
-        int oldPort;
-        getSyslogConfig(oldIp, oldPort);
-        if (oldIp == ip && oldPort == port) {
-            return; // only write new data!
-        }
+        ip = m_data.mqtt.ip;
+        port = m_data.mqtt.port;
+    }
 
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& jsonObjectRoot = m_storage.loadJson(jsonBuffer);
-        JsonObject& jsonobjectSyslog = jsonObjectRoot.get<JsonVariant>("syslog").as<JsonObject>();
-        jsonobjectSyslog.set("ip", ip);
-        jsonobjectSyslog.set("port", port);
-        m_storage.writeJson(jsonObjectRoot);
+    bool setSyslogConfig(const String& ip, const int& port)
+    {
+        return begin().setSyslog(ip, port).commit();
     }
 
     void getSyslogConfig(String& ip, int& port) const
     {
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& jsonobjectSyslog = m_storage.loadJson(jsonBuffer).get<JsonVariant>("syslog").as<JsonObject>();
-        ip = jsonobjectSyslog.get<String>("ip");
-        port = jsonobjectSyslog.get<int>("port");
+        ip = m_data.syslog.ip;
+        port = m_data.syslog.port;
     }
 
 private:
-    bool setup()
+    bool save()
     {
-        bool newConfig = false;
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& jsonObjectRoot = m_storage.loadJson(jsonBuffer);
-        if (!jsonObjectRoot.containsKey("version")) {
-            jsonObjectRoot.set("version", "2.0");
-            newConfig = true;
-        }
+        RequestArena::Scope scope;
+        ArenaJsonBuffer jsonBuffer;
+        JsonObject& jsonObjectRoot = jsonBuffer.createObject();
+        jsonObjectRoot.set("version", m_data.version);
 
-        // read wifi config or create default wifi config
-        JsonObject& jsonobjectWifi = !jsonObjectRoot.containsKey("wifi")
-            ? jsonObjectRoot.createNestedObject("wifi")
-            : jsonObjectRoot.get<JsonVariant>("wifi").as<JsonObject>();
+        JsonObject& jsonobjectWifi = jsonObjectRoot.createNestedObject("wifi");
+        jsonobjectWifi.set("ssid", m_data.wifi.ssid);
+        jsonobjectWifi.set("pass", m_data.wifi.pass);
 
-        if (!jsonobjectWifi.containsKey("ssid")) {
-            jsonobjectWifi.set("ssid", "");
-            newConfig = true;
-        }
-        if (!jsonobjectWifi.containsKey("pass")) {
-            jsonobjectWifi.set("pass", "");
-            newConfig = true;
-        }
-
-        // read mqtt config or create default mqtt config
-        JsonObject& jsonobjectMqtt = !jsonObjectRoot.containsKey("mqtt")
-            ? jsonObjectRoot.createNestedObject("mqtt")
-            : jsonObjectRoot.get<JsonVariant>("mqtt").as<JsonObject>();
+        JsonObject& jsonobjectMqtt = jsonObjectRoot.createNestedObject("mqtt");
+        jsonobjectMqtt.set("ip", m_data.mqtt.ip);
+        jsonobjectMqtt.set("port", m_data.mqtt.port);
 
-        if (!jsonobjectMqtt.containsKey("ip")) {
-            jsonobjectMqtt.set("ip", "");
-            newConfig = true;
-        }
-        if (!jsonobjectMqtt.containsKey("port")) {
-            jsonobjectMqtt.set("port", 1883);
-            newConfig = true;
-        }
+        JsonObject& jsonobjectSyslog = jsonObjectRoot.createNestedObject("syslog");
+        jsonobjectSyslog.set("ip", m_data.syslog.ip);
+        jsonobjectSyslog.set("port", m_data.syslog.port);
 
-        // read syslog config or create default syslog config
-        JsonObject& jsonobjectSyslog = !jsonObjectRoot.containsKey("syslog")
-            ? jsonObjectRoot.createNestedObject("syslog")
-            : jsonObjectRoot.get<JsonVariant>("syslog").as<JsonObject>();
-
-        if (!jsonobjectSyslog.containsKey("ip")) {
-            jsonobjectSyslog.set("ip", "");
-            newConfig = true;
-        }
-        if (!jsonobjectSyslog.containsKey("port")) {
-            jsonobjectSyslog.set("port", 514);
-            newConfig = true;
-        }
-
-        if (newConfig) {
-            return m_storage.writeJson(jsonObjectRoot); // only write new data!
-        }
-
-        return true;
+        return m_storage.writeJson(jsonObjectRoot);
     }
 
     Storage m_storage;
+    Data m_data;
 };
 
-#endif
\ No newline at end of file
+#endif
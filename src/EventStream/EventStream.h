@@ -0,0 +1,200 @@
+#ifndef EventStream_h
+#define EventStream_h
+
+#include <Arduino.h>
+
+#ifndef EVENT_STREAM_CAPACITY
+#define EVENT_STREAM_CAPACITY 2
+#endif
+
+#ifndef EVENT_STREAM_BUFFER_SIZE
+#define EVENT_STREAM_BUFFER_SIZE 512
+#endif
+
+/**
+ * Server-sent events (text/event-stream) to a bounded set of subscribers.
+ *
+ * Every subscriber owns a connection and a fixed send buffer. Publishing
+ * only appends to the buffers, serve() hands them to the clients as far as
+ * their socket can take it without blocking. A subscriber whose buffer
+ * overflows is disconnected (EventSource reconnects by itself and gets the
+ * full state again), so a slow client never stalls the loop.
+ *
+ * @tparam Client: WiFiClient(Secure), copies share the connection
+ *
+ * ussage e.g.:
+ * EventStream<BearSSL::WiFiClientSecure> events;
+ * int id = events.subscribe(server->client(), EventStream<...>::TOPIC_RELAY);
+ * events.publish(EventStream<...>::TOPIC_RELAY, "relay", "{\"relay\":1,\"value\":true}");
+ * events.serve();
+ */
+template <class Client, size_t capacity = EVENT_STREAM_CAPACITY, size_t bufferSize = EVENT_STREAM_BUFFER_SIZE>
+class EventStream {
+public:
+    static const uint8_t TOPIC_RELAY = 1 << 0;
+    static const uint8_t TOPIC_METRICS = 1 << 1;
+    static const uint8_t TOPIC_ALL = 0xFF;
+
+    EventStream()
+        : m_dropped(0)
+    {
+        for (size_t i = 0; i < capacity; i++) {
+            m_subscribers[i].active = false;
+        }
+    }
+
+    /**
+     * Take over the connection and queue the response header.
+     *
+     * @return subscriber id, -1 if all slots are taken
+     */
+    int subscribe(const Client& client, uint8_t topics)
+    {
+        for (size_t i = 0; i < capacity; i++) {
+            Subscriber& subscriber = m_subscribers[i];
+            if (subscriber.active) {
+                continue;
+            }
+
+            subscriber.client = client;
+            subscriber.client.setNoDelay(true);
+            subscriber.topics = topics;
+            subscriber.length = 0;
+            subscriber.active = true;
+            append(subscriber, "HTTP/1.1 200 OK\r\n"
+                               "Content-Type: text/event-stream\r\n"
+                               "Cache-Control: no-cache\r\n"
+                               "Connection: keep-alive\r\n"
+                               "\r\n");
+            return i;
+        }
+        return -1;
+    }
+
+    /**
+     * @return amount of subscribers that got the event
+     */
+    size_t publish(uint8_t topic, const char* event, const char* data)
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < capacity; i++) {
+            if (m_subscribers[i].active && (m_subscribers[i].topics & topic)) {
+                count += publishTo(i, event, data);
+            }
+        }
+        return count;
+    }
+
+    bool publishTo(int id, const char* event, const char* data)
+    {
+        Subscriber& subscriber = m_subscribers[id];
+        return append(subscriber, "event: ") && append(subscriber, event)
+            && append(subscriber, "\ndata: ") && append(subscriber, data) && append(subscriber, "\n\n");
+    }
+
+    /**
+     * Comment frame to every subscriber, keeps proxies and NAT from
+     * closing an idle stream and detects dead clients.
+     */
+    void heartbeat()
+    {
+        for (size_t i = 0; i < capacity; i++) {
+            if (m_subscribers[i].active) {
+                append(m_subscribers[i], ": heartbeat\n\n");
+            }
+        }
+    }
+
+    /**
+     * Write the pending data, never more than the sockets accept right now.
+     */
+    void serve()
+    {
+        for (size_t i = 0; i < capacity; i++) {
+            Subscriber& subscriber = m_subscribers[i];
+            if (!subscriber.active) {
+                continue;
+            }
+            if (!subscriber.client.connected()) {
+                drop(subscriber);
+                continue;
+            }
+            if (!subscriber.length) {
+                continue;
+            }
+
+            int space = subscriber.client.availableForWrite();
+            if (space <= 0) {
+                continue;
+            }
+            size_t written = subscriber.client.write((const uint8_t*)subscriber.buffer, min((size_t)space, subscriber.length));
+            subscriber.length -= written;
+            memmove(subscriber.buffer, subscriber.buffer + written, subscriber.length);
+        }
+    }
+
+    void clear()
+    {
+        for (size_t i = 0; i < capacity; i++) {
+            if (m_subscribers[i].active) {
+                drop(m_subscribers[i]);
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < capacity; i++) {
+            count += m_subscribers[i].active;
+        }
+        return count;
+    }
+
+    /**
+     * @return amount of subscribers that were disconnected because they couldn't keep up
+     */
+    uint32_t getDropped() const
+    {
+        return m_dropped;
+    }
+
+private:
+    struct Subscriber {
+        Client client;
+        uint8_t topics;
+        bool active;
+        size_t length;
+        char buffer[bufferSize];
+    };
+
+    bool append(Subscriber& subscriber, const char* text)
+    {
+        if (!subscriber.active) {
+            return false;
+        }
+
+        size_t length = strlen(text);
+        if (subscriber.length + length > bufferSize) {
+            m_dropped++;
+            drop(subscriber);
+            return false;
+        }
+        memcpy(subscriber.buffer + subscriber.length, text, length);
+        subscriber.length += length;
+        return true;
+    }
+
+    void drop(Subscriber& subscriber)
+    {
+        subscriber.client.stop();
+        subscriber.client = Client();
+        subscriber.active = false;
+        subscriber.length = 0;
+    }
+
+    Subscriber m_subscribers[capacity];
+    uint32_t m_dropped;
+};
+
+#endif
@@ -0,0 +1,237 @@
+#ifndef JsonWriter_h
+#define JsonWriter_h
+
+#include <Arduino.h>
+#include <cmath>
+#include <type_traits>
+
+/**
+ * Forward-only compact JSON writer.
+ *
+ * Nothing is buffered or allocated, every token is written straight into the
+ * given Print, which makes it a good fit for streaming responses.
+ *
+ * ussage e.g.:
+ * JsonWriter json(out);
+ * json.beginObject();
+ * json.set(F("free_heap"), ESP.getFreeHeap());
+ * json.beginObject(F("wifi"));
+ * json.set(F("ssid"), ssid);
+ * json.endObject();
+ * json.endObject();
+ */
+class JsonWriter {
+public:
+    JsonWriter(Print& out)
+        : m_out(out)
+        , m_depth(0)
+        , m_notEmpty(0)
+    {
+    }
+
+    JsonWriter& beginObject()
+    {
+        separate();
+        return open('{');
+    }
+
+    template <typename Key>
+    JsonWriter& beginObject(const Key& key)
+    {
+        writeKey(key);
+        return open('{');
+    }
+
+    JsonWriter& endObject()
+    {
+        return close('}');
+    }
+
+    JsonWriter& beginArray()
+    {
+        separate();
+        return open('[');
+    }
+
+    template <typename Key>
+    JsonWriter& beginArray(const Key& key)
+    {
+        writeKey(key);
+        return open('[');
+    }
+
+    JsonWriter& endArray()
+    {
+        return close(']');
+    }
+
+    /**
+     * write a "key": value member into the current object
+     */
+    template <typename Key, typename Value>
+    JsonWriter& set(const Key& key, const Value& value)
+    {
+        writeKey(key);
+        writeValue(value);
+        return *this;
+    }
+
+    /**
+     * write a value into the current array
+     */
+    template <typename Value>
+    JsonWriter& add(const Value& value)
+    {
+        separate();
+        writeValue(value);
+        return *this;
+    }
+
+private:
+    JsonWriter& open(char token)
+    {
+        m_out.write(token);
+        m_depth++;
+        m_notEmpty &= ~mask();
+        return *this;
+    }
+
+    JsonWriter& close(char token)
+    {
+        m_out.write(token);
+        if (m_depth) {
+            m_depth--;
+        }
+        return *this;
+    }
+
+    uint32_t mask() const
+    {
+        return m_depth < 32 ? (1UL << m_depth) : 0;
+    }
+
+    void separate()
+    {
+        if (m_notEmpty & mask()) {
+            m_out.write(',');
+        }
+        m_notEmpty |= mask();
+    }
+
+    template <typename Key>
+    void writeKey(const Key& key)
+    {
+        separate();
+        writeValue(key);
+        m_out.write(':');
+    }
+
+    void writeValue(bool value)
+    {
+        m_out.print(value ? F("true") : F("false"));
+    }
+
+    void writeValue(double value)
+    {
+        if (std::isnan(value) || std::isinf(value)) {
+            m_out.print(F("null"));
+            return;
+        }
+        m_out.print(value, 6);
+    }
+
+    template <typename T>
+    typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value) && !std::is_same<T, bool>::value>::type
+    writeValue(const T& value)
+    {
+        if (sizeof(T) > sizeof(long)) {
+            if (std::is_signed<T>::value && (long long)value < 0) {
+                m_out.write('-');
+                writeUInt64(0ULL - (unsigned long long)value);
+            } else {
+                writeUInt64((unsigned long long)value);
+            }
+        } else if (std::is_signed<T>::value) {
+            m_out.print((long)value);
+        } else {
+            m_out.print((unsigned long)value);
+        }
+    }
+
+    void writeUInt64(unsigned long long value)
+    {
+        char digits[21];
+        char* p = digits + sizeof(digits) - 1;
+        *p = '\0';
+        do {
+            *--p = '0' + value % 10;
+            value /= 10;
+        } while (value);
+        m_out.print(p);
+    }
+
+    void writeValue(const char* value)
+    {
+        if (!value) {
+            m_out.print(F("null"));
+            return;
+        }
+        m_out.write('"');
+        while (*value) {
+            writeChar(*value++);
+        }
+        m_out.write('"');
+    }
+
+    void writeValue(const String& value)
+    {
+        writeValue(value.c_str());
+    }
+
+    void writeValue(const __FlashStringHelper* value)
+    {
+        PGM_P p = reinterpret_cast<PGM_P>(value);
+        m_out.write('"');
+        for (char c = pgm_read_byte(p); c; c = pgm_read_byte(++p)) {
+            writeChar(c);
+        }
+        m_out.write('"');
+    }
+
+    void writeChar(char c)
+    {
+        switch (c) {
+        case '"':
+            m_out.print(F("\\\""));
+            return;
+        case '\\':
+            m_out.print(F("\\\\"));
+            return;
+        case '\n':
+            m_out.print(F("\\n"));
+            return;
+        case '\r':
+            m_out.print(F("\\r"));
+            return;
+        case '\t':
+            m_out.print(F("\\t"));
+            return;
+        default:
+            break;
+        }
+
+        if ((uint8_t)c < 0x20) {
+            char escaped[7];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (uint8_t)c);
+            m_out.print(escaped);
+            return;
+        }
+        m_out.write((uint8_t)c);
+    }
+
+    Print& m_out;
+    uint8_t m_depth;
+    uint32_t m_notEmpty; // one bit per nesting level: a member was already written
+};
+
+#endif
@@ -0,0 +1,397 @@
+#ifndef KeyValueStore_h
+#define KeyValueStore_h
+
+#include <Arduino.h>
+#include "LittleFS.h"
+
+#ifndef KV_STORE_CAPACITY
+#define KV_STORE_CAPACITY 8
+#endif
+
+#ifndef KV_SEGMENT_SIZE
+#define KV_SEGMENT_SIZE 4096
+#endif
+
+#define KV_KEY_MAX 32
+#define KV_VALUE_MAX 1024
+#define KV_RECORD_MAGIC 0xA5
+#define KV_TOMBSTONE 0xFFFF
+
+/**
+ * Small append-only key-value store in a single log file (segment).
+ *
+ * Every update appends one CRC-checked record instead of rewriting a file.
+ * The live values are kept in RAM, so reads never touch the flash. When the
+ * segment is full, the live records are written to a new segment which
+ * replaces the old one with an (atomic) rename. A torn or corrupt tail,
+ * e.g. after a power loss during an append, is dropped at load.
+ *
+ * A deferred set only updates the RAM copy, flush() appends all pending
+ * values at once, so a burst of updates costs a single write.
+ *
+ * record: magic (1), key length (1), value length (2, 0xFFFF: deleted),
+ * crc32 (4) over the lengths, key and value, key, value
+ *
+ * ussage e.g.:
+ * KeyValueStore store("/kv/store.log");
+ * store.set("bootcount", "12");
+ * String value;
+ * store.get("bootcount", value);
+ */
+class KeyValueStore {
+public:
+    KeyValueStore(const char* path, FS* fs = &LittleFS)
+        : m_path(path)
+        , m_fs(fs)
+        , m_loaded(false)
+        , m_segmentSize(0)
+        , m_compactions(0)
+        , m_pending(false)
+        , m_pendingSinceMs(0)
+    {
+    }
+
+    bool get(const String& key, String& value)
+    {
+        load();
+        Entry* entry = find(key);
+        if (!entry) {
+            return false;
+        }
+        value = entry->value;
+        return true;
+    }
+
+    bool contains(const String& key)
+    {
+        load();
+        return find(key) != nullptr;
+    }
+
+    /**
+     * @param defer: only update the RAM copy, written by the next flush()
+     */
+    bool set(const String& key, const String& value, bool defer = false)
+    {
+        if (!key.length() || key.length() > KV_KEY_MAX || value.length() > KV_VALUE_MAX) {
+            return false;
+        }
+
+        load();
+        Entry* entry = find(key);
+        if (entry && entry->value == value) {
+            return true; // only write new data!
+        }
+        if (!entry) {
+            entry = find("");
+            if (!entry) {
+                return false; // full
+            }
+            entry->key = key;
+        }
+        entry->value = value;
+        entry->dirty = true;
+        if (!m_pending) {
+            m_pending = true;
+            m_pendingSinceMs = millis();
+        }
+        return defer || flush();
+    }
+
+    bool remove(const String& key)
+    {
+        load();
+        Entry* entry = find(key);
+        if (!entry) {
+            return false;
+        }
+        entry->key = "";
+        entry->value = "";
+        entry->dirty = false;
+        return write(key, nullptr, KV_TOMBSTONE);
+    }
+
+    /**
+     * Write all pending values.
+     */
+    bool flush()
+    {
+        if (!m_pending) {
+            return true;
+        }
+
+        size_t recordsSize = 0;
+        for (size_t i = 0; i < KV_STORE_CAPACITY; i++) {
+            const Entry& entry = m_entries[i];
+            if (entry.dirty) {
+                recordsSize += sizeof(RecordHeader) + entry.key.length() + entry.value.length();
+            }
+        }
+        if (m_segmentSize + recordsSize > KV_SEGMENT_SIZE) {
+            return compact();
+        }
+
+        File file = m_fs->open(m_path, "a");
+        if (!file) {
+            return false;
+        }
+        size_t written = 0;
+        for (size_t i = 0; i < KV_STORE_CAPACITY; i++) {
+            const Entry& entry = m_entries[i];
+            if (entry.dirty) {
+                written += writeRecord(file, entry.key, entry.value.c_str(), entry.value.length());
+            }
+        }
+        file.close();
+        if (written != recordsSize) {
+            return compact(); // don't leave a torn record in front of the next one
+        }
+
+        m_segmentSize += written;
+        clearPending();
+        return true;
+    }
+
+    bool isPending() const
+    {
+        return m_pending;
+    }
+
+    /**
+     * @return time of the oldest write that's not flushed yet
+     */
+    unsigned long getPendingSinceMs() const
+    {
+        return m_pendingSinceMs;
+    }
+
+    size_t size()
+    {
+        load();
+        size_t count = 0;
+        for (size_t i = 0; i < KV_STORE_CAPACITY; i++) {
+            count += m_entries[i].key.length() > 0;
+        }
+        return count;
+    }
+
+    /**
+     * @return bytes in use by the log, live and stale records
+     */
+    size_t getSegmentSize() const
+    {
+        return m_segmentSize;
+    }
+
+    uint32_t getCompactions() const
+    {
+        return m_compactions;
+    }
+
+    /**
+     * Rewrite the log with only the live records.
+     */
+    bool compact()
+    {
+        String tmpPath = m_path + ".tmp";
+        File file = m_fs->open(tmpPath, "w");
+        if (!file) {
+            return false;
+        }
+
+        size_t segmentSize = 0;
+        for (size_t i = 0; i < KV_STORE_CAPACITY; i++) {
+            const Entry& entry = m_entries[i];
+            if (!entry.key.length()) {
+                continue;
+            }
+            size_t written = writeRecord(file, entry.key, entry.value.c_str(), entry.value.length());
+            if (!written) {
+                file.close();
+                m_fs->remove(tmpPath);
+                return false;
+            }
+            segmentSize += written;
+        }
+        file.close();
+
+        if (!m_fs->rename(tmpPath, m_path)) {
+            m_fs->remove(tmpPath);
+            return false;
+        }
+        m_segmentSize = segmentSize;
+        m_compactions++;
+        clearPending(); // the new segment holds every value
+        return true;
+    }
+
+private:
+    struct Entry {
+        String key; // empty: free slot
+        String value;
+        bool dirty = false; // not written yet
+    };
+
+    struct __attribute__((packed)) RecordHeader {
+        uint8_t magic;
+        uint8_t keyLength;
+        uint16_t valueLength;
+        uint32_t crc;
+    };
+
+    void clearPending()
+    {
+        for (size_t i = 0; i < KV_STORE_CAPACITY; i++) {
+            m_entries[i].dirty = false;
+        }
+        m_pending = false;
+    }
+
+    Entry* find(const String& key)
+    {
+        for (size_t i = 0; i < KV_STORE_CAPACITY; i++) {
+            if (m_entries[i].key == key) {
+                return &m_entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    void load()
+    {
+        if (m_loaded) {
+            return;
+        }
+        m_loaded = true;
+        m_segmentSize = 0;
+
+        String tmpPath = m_path + ".tmp";
+        if (m_fs->exists(tmpPath)) {
+            m_fs->remove(tmpPath); // interrupted compaction, the old segment is still complete
+        }
+
+        File file = m_fs->open(m_path, "r");
+        if (!file) {
+            return;
+        }
+
+        bool corrupt = false;
+        while (file.available()) {
+            RecordHeader header;
+            if (file.read((uint8_t*)&header, sizeof(header)) != sizeof(header) || header.magic != KV_RECORD_MAGIC
+                || !header.keyLength || header.keyLength > KV_KEY_MAX
+                || (header.valueLength > KV_VALUE_MAX && header.valueLength != KV_TOMBSTONE)) {
+                corrupt = true;
+                break;
+            }
+
+            char key[KV_KEY_MAX + 1];
+            if (file.read((uint8_t*)key, header.keyLength) != header.keyLength) {
+                corrupt = true;
+                break;
+            }
+            key[header.keyLength] = '\0';
+
+            uint32_t crc = crc32((const uint8_t*)&header + 1, 3, 0xFFFFFFFF);
+            crc = crc32((const uint8_t*)key, header.keyLength, crc);
+
+            String value;
+            size_t valueLength = header.valueLength == KV_TOMBSTONE ? 0 : header.valueLength;
+            value.reserve(valueLength);
+            while (valueLength) {
+                char chunk[64];
+                size_t length = min(valueLength, sizeof(chunk));
+                if (file.read((uint8_t*)chunk, length) != length) {
+                    break;
+                }
+                crc = crc32((const uint8_t*)chunk, length, crc);
+                value.concat(chunk, length);
+                valueLength -= length;
+            }
+            if (valueLength || ~crc != header.crc) {
+                corrupt = true;
+                break;
+            }
+
+            Entry* entry = find(key);
+            if (header.valueLength == KV_TOMBSTONE) {
+                if (entry) {
+                    entry->key = "";
+                    entry->value = "";
+                }
+            } else if (entry || (entry = find(""))) {
+                entry->key = key;
+                entry->value = value;
+            }
+            m_segmentSize = file.position();
+        }
+        file.close();
+
+        if (corrupt) {
+            compact(); // drop the torn tail, new records can't follow garbage
+        }
+    }
+
+    bool write(const String& key, const char* value, uint16_t valueLength)
+    {
+        size_t recordSize = sizeof(RecordHeader) + key.length() + (valueLength == KV_TOMBSTONE ? 0 : valueLength);
+        if (m_segmentSize + recordSize > KV_SEGMENT_SIZE) {
+            return compact(); // the new value is already in RAM
+        }
+
+        File file = m_fs->open(m_path, "a");
+        if (!file) {
+            return false;
+        }
+        size_t written = writeRecord(file, key, value, valueLength);
+        file.close();
+        if (written != recordSize) {
+            return compact(); // don't leave a torn record in front of the next one
+        }
+        m_segmentSize += written;
+        return true;
+    }
+
+    static size_t writeRecord(File& file, const String& key, const char* value, uint16_t valueLength)
+    {
+        RecordHeader header;
+        header.magic = KV_RECORD_MAGIC;
+        header.keyLength = key.length();
+        header.valueLength = valueLength;
+        size_t length = valueLength == KV_TOMBSTONE ? 0 : valueLength;
+
+        uint32_t crc = crc32((const uint8_t*)&header + 1, 3, 0xFFFFFFFF);
+        crc = crc32((const uint8_t*)key.c_str(), key.length(), crc);
+        crc = crc32((const uint8_t*)value, length, crc);
+        header.crc = ~crc;
+
+        size_t written = file.write((const uint8_t*)&header, sizeof(header));
+        written += file.write((const uint8_t*)key.c_str(), key.length());
+        if (length) {
+            written += file.write((const uint8_t*)value, length);
+        }
+        return written == sizeof(header) + key.length() + length ? written : 0;
+    }
+
+    static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc)
+    {
+        while (length--) {
+            crc ^= *data++;
+            for (uint8_t bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+            }
+        }
+        return crc;
+    }
+
+    String m_path;
+    FS* m_fs;
+    bool m_loaded;
+    size_t m_segmentSize;
+    uint32_t m_compactions;
+    bool m_pending;
+    unsigned long m_pendingSinceMs;
+    Entry m_entries[KV_STORE_CAPACITY];
+};
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef Metrics_h
+#define Metrics_h
+
+#include <Arduino.h>
+
+#ifndef METRICS_ROUTE_CAPACITY
+#define METRICS_ROUTE_CAPACITY 20
+#endif
+
+#ifndef METRICS_RELAY_CAPACITY
+#define METRICS_RELAY_CAPACITY 8
+#endif
+
+#define METRICS_LATENCY_BUCKETS 9
+
+/**
+ * Preallocated counters, printed in the Prometheus text exposition format.
+ *
+ * Routes are registered once at setup, a request is measured between
+ * beginRequest() and endRequest(). Every status code >= 400 counts as error.
+ * Lines end in '\n' only, println() would end them in "\r\n", which the
+ * text format doesn't allow.
+ *
+ * ussage e.g.:
+ * int route = metrics.addRoute("/api/get", "GET");
+ * metrics.beginRequest(route);
+ * metrics.setStatus(400);
+ * metrics.endRequest();
+ * metrics.printTo(out);
+ */
+class Metrics {
+public:
+    struct Route {
+        const char* path;
+        const char* method;
+        uint32_t requests;
+        uint32_t errors;
+        uint32_t latency[METRICS_LATENCY_BUCKETS]; // not cumulative
+        uint64_t latencySumUs;
+    };
+
+    Metrics()
+        : m_routeCount(0)
+        , m_current(-1)
+        , m_status(200)
+        , m_requestStartUs(0)
+        , m_wifiReconnects(0)
+    {
+        memset(m_relayToggles, 0, sizeof(m_relayToggles));
+    }
+
+    /**
+     * @return route index, -1 if there's no free route slot
+     */
+    int addRoute(const char* path, const char* method)
+    {
+        if (m_routeCount == METRICS_ROUTE_CAPACITY) {
+            return -1;
+        }
+
+        Route& route = m_routes[m_routeCount];
+        memset(&route, 0, sizeof(route));
+        route.path = path;
+        route.method = method;
+        return m_routeCount++;
+    }
+
+    void beginRequest(int route)
+    {
+        m_current = route;
+        m_status = 200;
+        m_requestStartUs = micros();
+    }
+
+    void setStatus(int status)
+    {
+        m_status = status;
+    }
+
+    void endRequest()
+    {
+        if (m_current < 0 || m_current >= (int)m_routeCount) {
+            return;
+        }
+
+        Route& route = m_routes[m_current];
+        uint32_t latencyUs = micros() - m_requestStartUs;
+        route.requests++;
+        if (m_status >= 400) {
+            route.errors++;
+        }
+        route.latencySumUs += latencyUs;
+
+        size_t bucket = 0;
+        while (bucket < METRICS_LATENCY_BUCKETS && latencyUs > bucketBoundUs(bucket)) {
+            bucket++;
+        }
+        if (bucket < METRICS_LATENCY_BUCKETS) {
+            route.latency[bucket]++;
+        }
+        m_current = -1;
+    }
+
+    void countWifiReconnect()
+    {
+        m_wifiReconnects++;
+    }
+
+    uint32_t getWifiReconnects() const
+    {
+        return m_wifiReconnects;
+    }
+
+    /**
+     * @param relay: relay id, starts at 1
+     */
+    void countRelayToggle(uint8_t relay)
+    {
+        if (relay && relay <= METRICS_RELAY_CAPACITY) {
+            m_relayToggles[relay - 1]++;
+        }
+    }
+
+    uint32_t getRelayToggles(uint8_t relay) const
+    {
+        return relay && relay <= METRICS_RELAY_CAPACITY ? m_relayToggles[relay - 1] : 0;
+    }
+
+    /**
+     * print the http and relay counters
+     *
+     * @param relayCount: amount of relays to print (relay ids start at 1)
+     */
+    void printTo(Print& out, uint8_t relayCount) const
+    {
+        printHeader(out, F("smarthue_http_requests_total"), F("counter"), F("Handled http requests per route."));
+        for (size_t i = 0; i < m_routeCount; i++) {
+            printRouteSample(out, F("smarthue_http_requests_total"), m_routes[i], m_routes[i].requests);
+        }
+
+        printHeader(out, F("smarthue_http_errors_total"), F("counter"), F("Http responses with status >= 400 per route."));
+        for (size_t i = 0; i < m_routeCount; i++) {
+            printRouteSample(out, F("smarthue_http_errors_total"), m_routes[i], m_routes[i].errors);
+        }
+
+        printHeader(out, F("smarthue_http_request_duration_seconds"), F("histogram"), F("Http handler latency per route."));
+        for (size_t i = 0; i < m_routeCount; i++) {
+            const Route& route = m_routes[i];
+            uint32_t cumulative = 0;
+            for (size_t bucket = 0; bucket < METRICS_LATENCY_BUCKETS; bucket++) {
+                cumulative += route.latency[bucket];
+                printRouteLabels(out, F("smarthue_http_request_duration_seconds_bucket"), route);
+                out.print(F(",le=\""));
+                out.print(bucketBoundUs(bucket) / 1000000.0, 3);
+                out.print(F("\"} "));
+                out.print(cumulative);
+                out.print('\n');
+            }
+            printRouteLabels(out, F("smarthue_http_request_duration_seconds_bucket"), route);
+            out.print(F(",le=\"+Inf\"} "));
+            out.print(route.requests);
+            out.print('\n');
+
+            printRouteLabels(out, F("smarthue_http_request_duration_seconds_sum"), route);
+            out.print(F("} "));
+            out.print(route.latencySumUs / 1000000.0, 6);
+            out.print('\n');
+
+            printRouteSample(out, F("smarthue_http_request_duration_seconds_count"), route, route.requests);
+        }
+
+        printHeader(out, F("smarthue_wifi_reconnects_total"), F("counter"), F("WiFi reconnect attempts."));
+        printSample(out, F("smarthue_wifi_reconnects_total"), m_wifiReconnects);
+
+        printHeader(out, F("smarthue_relay_toggles_total"), F("counter"), F("Relay state changes per relay."));
+        for (uint8_t relay = 1; relay <= relayCount && relay <= METRICS_RELAY_CAPACITY; relay++) {
+            out.print(F("smarthue_relay_toggles_total{relay=\""));
+            out.print(relay);
+            out.print(F("\"} "));
+            out.print(m_relayToggles[relay - 1]);
+            out.print('\n');
+        }
+    }
+
+    static void printHeader(Print& out, const __FlashStringHelper* name, const __FlashStringHelper* type, const __FlashStringHelper* help)
+    {
+        out.print(F("# HELP "));
+        out.print(name);
+        out.print(' ');
+        out.print(help);
+        out.print('\n');
+        out.print(F("# TYPE "));
+        out.print(name);
+        out.print(' ');
+        out.print(type);
+        out.print('\n');
+    }
+
+    template <typename Value>
+    static void printSample(Print& out, const __FlashStringHelper* name, const Value& value)
+    {
+        out.print(name);
+        out.print(' ');
+        out.print(value);
+        out.print('\n');
+    }
+
+    /**
+     * print a single gauge, including its HELP and TYPE lines
+     */
+    template <typename Value>
+    static void printGauge(Print& out, const __FlashStringHelper* name, const __FlashStringHelper* help, const Value& value)
+    {
+        printHeader(out, name, F("gauge"), help);
+        printSample(out, name, value);
+    }
+
+    /**
+     * print a single counter, including its HELP and TYPE lines
+     */
+    template <typename Value>
+    static void printCounter(Print& out, const __FlashStringHelper* name, const __FlashStringHelper* help, const Value& value)
+    {
+        printHeader(out, name, F("counter"), help);
+        printSample(out, name, value);
+    }
+
+private:
+    // upper bounds: 5ms, 10ms, 25ms, 50ms, 100ms, 250ms, 500ms, 1s, 2.5s
+    static uint32_t bucketBoundUs(size_t bucket)
+    {
+        static const uint32_t bounds[METRICS_LATENCY_BUCKETS] = {
+            5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 2500000
+        };
+        return bounds[bucket];
+    }
+
+    static void printRouteLabels(Print& out, const __FlashStringHelper* name, const Route& route)
+    {
+        out.print(name);
+        out.print(F("{route=\""));
+        out.print(route.path);
+        out.print(F("\",method=\""));
+        out.print(route.method);
+        out.print('"');
+    }
+
+    static void printRouteSample(Print& out, const __FlashStringHelper* name, const Route& route, uint32_t value)
+    {
+        printRouteLabels(out, name, route);
+        out.print(F("} "));
+        out.print(value);
+        out.print('\n');
+    }
+
+    Route m_routes[METRICS_ROUTE_CAPACITY];
+    size_t m_routeCount;
+    int m_current;
+    int m_status;
+    unsigned long m_requestStartUs;
+    uint32_t m_wifiReconnects;
+    uint32_t m_relayToggles[METRICS_RELAY_CAPACITY];
+};
+
+#endif
@@ -0,0 +1,129 @@
+#ifndef RequestArena_h
+#define RequestArena_h
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef REQUEST_ARENA_SIZE
+#define REQUEST_ARENA_SIZE 1536
+#endif
+
+/**
+ * Preallocated bump allocator for the json and scratch text of a request.
+ *
+ * Allocations come from one fixed block and are released all at once
+ * when the Scope they were made in ends, onRoute() opens one around every
+ * handler, so the heap doesn't see the short lived buffers of a request.
+ * A scope can be nested, it only releases what was allocated within it.
+ *
+ * An allocation that doesn't fit, or that's made outside of a scope,
+ * falls back to the heap and is counted: size the arena with the high
+ * water mark and the fallback counter (/api/metrics).
+ *
+ * ussage e.g.:
+ * RequestArena::Scope scope;
+ * ArenaJsonBuffer jsonBuffer;
+ * JsonObject& root = jsonBuffer.createObject();
+ * char* text = (char*)RequestArena::instance().allocate(16);
+ */
+class RequestArena {
+public:
+    class Scope {
+    public:
+        Scope()
+            : m_arena(RequestArena::instance())
+            , m_mark(m_arena.m_used)
+        {
+            m_arena.m_depth++;
+        }
+
+        ~Scope()
+        {
+            m_arena.m_depth--;
+            m_arena.m_used = m_mark;
+        }
+
+    private:
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+        RequestArena& m_arena;
+        size_t m_mark;
+    };
+
+    static RequestArena& instance()
+    {
+        static RequestArena arena;
+        return arena;
+    }
+
+    void* allocate(size_t size)
+    {
+        // same rounding as the ArduinoJson buffers
+        size_t rounded = (size + sizeof(void*) - 1) & ~(sizeof(void*) - 1);
+        if (!m_depth || rounded > REQUEST_ARENA_SIZE - m_used) {
+            m_fallbacks++;
+            return malloc(size);
+        }
+
+        void* pointer = m_data + m_used;
+        m_used += rounded;
+        if (m_used > m_highWater) {
+            m_highWater = m_used;
+        }
+        return pointer;
+    }
+
+    /**
+     * only a fallback allocation is freed, the arena is released by its Scope
+     */
+    void deallocate(void* pointer)
+    {
+        if ((uint8_t*)pointer < m_data || (uint8_t*)pointer >= m_data + REQUEST_ARENA_SIZE) {
+            free(pointer);
+        }
+    }
+
+    size_t getUsed() const
+    {
+        return m_used;
+    }
+
+    size_t getHighWater() const
+    {
+        return m_highWater;
+    }
+
+    uint32_t getFallbacks() const
+    {
+        return m_fallbacks;
+    }
+
+private:
+    RequestArena() { }
+
+    alignas(8) uint8_t m_data[REQUEST_ARENA_SIZE];
+    size_t m_used = 0;
+    size_t m_highWater = 0;
+    uint32_t m_fallbacks = 0;
+    uint8_t m_depth = 0;
+};
+
+/**
+ * Allocator of ArduinoJson's DynamicJsonBuffer on the request arena
+ */
+struct ArenaAllocator {
+    void* allocate(size_t size)
+    {
+        return RequestArena::instance().allocate(size);
+    }
+
+    void deallocate(void* pointer)
+    {
+        RequestArena::instance().deallocate(pointer);
+    }
+};
+
+typedef ArduinoJson::Internals::DynamicJsonBufferBase<ArenaAllocator> ArenaJsonBuffer;
+
+#endif
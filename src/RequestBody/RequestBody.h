@@ -0,0 +1,83 @@
+#ifndef RequestBody_h
+#define RequestBody_h
+
+#include "CborReader/CborReader.h"
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+/**
+ * Fixed size buffer for a request body, parsed in place.
+ *
+ * The server streams the body into the buffer chunk by chunk (the raw
+ * body hook of the webserver) and it's parsed there, the strings in the
+ * tree point into the buffer. Together with a StaticJsonBuffer nothing of
+ * the request ends up on the heap. Once the body doesn't fit, the rest of
+ * it is dropped and the body is marked as overflowed.
+ *
+ * One buffer serves every request, the server handles one at a time,
+ * the tree is only valid until the next begin().
+ *
+ * ussage e.g.:
+ * RequestBody<1024> body;
+ * body.begin();
+ * body.write(raw.buf, raw.currentSize);
+ * if (body.isOverflow()) { 413 }
+ * StaticJsonBuffer<JSON_OBJECT_SIZE(2)> jsonBuffer;
+ * JsonObject& root = body.parseJson(jsonBuffer).as<JsonObject>();
+ */
+template <size_t SIZE>
+class RequestBody {
+public:
+    void begin()
+    {
+        m_length = 0;
+        m_overflow = false;
+        m_data[0] = '\0';
+    }
+
+    /**
+     * append a chunk of the body
+     *
+     * @return false once the body is larger than SIZE
+     */
+    bool write(const uint8_t* data, size_t length)
+    {
+        if (m_overflow || length > SIZE - m_length) {
+            m_overflow = true;
+            return false;
+        }
+        memcpy(m_data + m_length, data, length);
+        m_length += length;
+        m_data[m_length] = '\0';
+        return true;
+    }
+
+    bool isOverflow() const
+    {
+        return m_overflow;
+    }
+
+    template <class JsonBuffer>
+    JsonVariant parseJson(JsonBuffer& jsonBuffer)
+    {
+        return jsonBuffer.parse(m_data);
+    }
+
+    template <class JsonBuffer>
+    JsonVariant parseCbor(JsonBuffer& jsonBuffer)
+    {
+        return CborReader::parse(jsonBuffer, (uint8_t*)m_data, m_length);
+    }
+
+    size_t length() const
+    {
+        return m_length;
+    }
+
+private:
+    char m_data[SIZE + 1] = {};
+    size_t m_length = 0;
+    bool m_overflow = false;
+};
+
+#endif
@@ -0,0 +1,287 @@
+#ifndef Scheduler_h
+#define Scheduler_h
+
+#include <Arduino.h>
+
+#ifndef SCHEDULER_CAPACITY
+#define SCHEDULER_CAPACITY 16
+#endif
+
+/**
+ * Latency histogram of every task, bucket i counts the calls that took
+ * [2^(base + i), 2^(base + i + 1)) cpu cycles, the first and the last
+ * bucket are open ended.
+ */
+#ifndef SCHEDULER_HISTOGRAM_BUCKETS
+#define SCHEDULER_HISTOGRAM_BUCKETS 12
+#endif
+
+#ifndef SCHEDULER_HISTOGRAM_BASE_LOG2
+#define SCHEDULER_HISTOGRAM_BASE_LOG2 10
+#endif
+
+/**
+ * Small cooperative scheduler backed by a fixed-capacity array.
+ *
+ * Every task has its own period, an optional "run when ready" condition,
+ * a priority (0 is the highest, tasks of equal priority keep their
+ * registration order) and an optional time budget. A task that exceeds its
+ * budget is not interrupted, but the overrun is counted.
+ *
+ * Every call is profiled with the cpu cycle counter: call count, total and
+ * max cycles and a log2 latency histogram.
+ *
+ * ussage e.g.:
+ * scheduler.add(serveWebServer, "webserver", 0, Scheduler::PRIORITY_HIGH);
+ * scheduler.add(serveMDNS, "mdns", 100, Scheduler::PRIORITY_LOW);
+ * scheduler.add(reconnect, "wifi", 5000, Scheduler::PRIORITY_LOW, []() { return !WiFi.isConnected(); });
+ * scheduler.run();
+ */
+class Scheduler {
+public:
+    typedef void (*Callback)();
+    typedef bool (*Condition)();
+
+    static const uint8_t PRIORITY_HIGH = 0;
+    static const uint8_t PRIORITY_NORMAL = 128;
+    static const uint8_t PRIORITY_LOW = 255;
+
+    struct Profile {
+        uint32_t calls;
+        uint32_t maxCycles;
+        uint64_t totalCycles;
+        uint32_t histogram[SCHEDULER_HISTOGRAM_BUCKETS];
+    };
+
+    struct Task {
+        Callback cb;
+        const char* name;
+        Condition ready; // optional, the task only runs if it returns true
+        unsigned long periodMs; // 0: every iteration
+        unsigned long budgetUs; // 0: no budget
+        unsigned long lastRunMs;
+        uint32_t overruns;
+        uint8_t priority;
+        Profile profile;
+    };
+
+    Scheduler()
+        : m_size(0)
+        , m_running(false)
+        , m_dirty(false)
+    {
+    }
+
+    /**
+     * Register a task, registering the same callback twice updates
+     * its settings instead.
+     *
+     * @return false if the scheduler is full
+     */
+    bool add(Callback cb, const char* name = nullptr, unsigned long periodMs = 0, uint8_t priority = PRIORITY_NORMAL,
+        Condition ready = nullptr, unsigned long budgetUs = 0)
+    {
+        if (!cb) {
+            return false;
+        }
+
+        Task* task = find(cb);
+        if (!task) {
+            if (m_size == SCHEDULER_CAPACITY) {
+                return false;
+            }
+            task = &m_tasks[m_size++];
+            task->cb = cb;
+            task->lastRunMs = millis() - periodMs; // due immediately
+            task->overruns = 0;
+            memset(&task->profile, 0, sizeof(task->profile));
+        }
+
+        task->name = name;
+        task->ready = ready;
+        task->periodMs = periodMs;
+        task->budgetUs = budgetUs;
+        task->priority = priority;
+
+        // the order can't change while the tasks are being iterated
+        if (m_running) {
+            m_dirty = true;
+        } else {
+            sort();
+        }
+        return true;
+    }
+
+    bool remove(Callback cb)
+    {
+        Task* task = find(cb);
+        if (!task) {
+            return false;
+        }
+
+        if (m_running) {
+            task->cb = nullptr; // compacted at the end of run()
+            m_dirty = true;
+        } else {
+            compact(task - m_tasks);
+        }
+        return true;
+    }
+
+    void clear()
+    {
+        if (m_running) {
+            for (size_t i = 0; i < m_size; i++) {
+                m_tasks[i].cb = nullptr;
+            }
+            m_dirty = true;
+        } else {
+            m_size = 0;
+        }
+    }
+
+    bool contains(Callback cb) const
+    {
+        return find(cb) != nullptr;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+    const Task& get(size_t index) const
+    {
+        return m_tasks[index];
+    }
+
+    void resetProfile()
+    {
+        for (size_t i = 0; i < m_size; i++) {
+            m_tasks[i].overruns = 0;
+            memset(&m_tasks[i].profile, 0, sizeof(m_tasks[i].profile));
+        }
+    }
+
+    /**
+     * @return lowest cycle count of the histogram bucket
+     */
+    static uint32_t bucketCycles(size_t bucket)
+    {
+        return bucket ? 1UL << (SCHEDULER_HISTOGRAM_BASE_LOG2 + bucket) : 0;
+    }
+
+    /**
+     * Run every task that is due, in priority order.
+     * Nested calls (from within a task) return immediately.
+     *
+     * @return the amount of executed tasks
+     */
+    size_t run()
+    {
+        if (m_running) {
+            return 0;
+        }
+
+        m_running = true;
+        size_t executed = 0;
+        for (size_t i = 0; i < m_size; i++) {
+            Task& task = m_tasks[i];
+            if (!task.cb) {
+                continue;
+            }
+
+            unsigned long timeNow = millis();
+            if (task.periodMs && timeNow - task.lastRunMs < task.periodMs) {
+                continue;
+            }
+            if (task.ready && !task.ready()) {
+                continue;
+            }
+
+            task.lastRunMs = timeNow;
+            unsigned long timeStart = micros();
+            uint32_t cycleStart = ESP.getCycleCount();
+            task.cb();
+            uint32_t cycles = ESP.getCycleCount() - cycleStart;
+            if (task.budgetUs && micros() - timeStart > task.budgetUs) {
+                task.overruns++;
+            }
+            profile(task.profile, cycles);
+            executed++;
+        }
+        m_running = false;
+
+        if (m_dirty) {
+            m_dirty = false;
+            for (size_t i = m_size; i-- > 0;) {
+                if (!m_tasks[i].cb) {
+                    compact(i);
+                }
+            }
+            sort();
+        }
+        return executed;
+    }
+
+private:
+    Task* find(Callback cb)
+    {
+        return const_cast<Task*>(static_cast<const Scheduler*>(this)->find(cb));
+    }
+
+    const Task* find(Callback cb) const
+    {
+        for (size_t i = 0; i < m_size; i++) {
+            if (m_tasks[i].cb == cb) {
+                return &m_tasks[i];
+            }
+        }
+        return nullptr;
+    }
+
+    static void profile(Profile& profile, uint32_t cycles)
+    {
+        profile.calls++;
+        profile.totalCycles += cycles;
+        if (profile.maxCycles < cycles) {
+            profile.maxCycles = cycles;
+        }
+
+        int bucket = (31 - __builtin_clz(cycles | 1)) - SCHEDULER_HISTOGRAM_BASE_LOG2;
+        if (bucket < 0) {
+            bucket = 0;
+        } else if (bucket >= SCHEDULER_HISTOGRAM_BUCKETS) {
+            bucket = SCHEDULER_HISTOGRAM_BUCKETS - 1;
+        }
+        profile.histogram[bucket]++;
+    }
+
+    void compact(size_t index)
+    {
+        for (size_t i = index; i + 1 < m_size; i++) {
+            m_tasks[i] = m_tasks[i + 1];
+        }
+        m_size--;
+    }
+
+    // stable insertion sort on priority, the array is tiny and nearly sorted
+    void sort()
+    {
+        for (size_t i = 1; i < m_size; i++) {
+            Task task = m_tasks[i];
+            size_t j = i;
+            for (; j > 0 && m_tasks[j - 1].priority > task.priority; j--) {
+                m_tasks[j] = m_tasks[j - 1];
+            }
+            m_tasks[j] = task;
+        }
+    }
+
+    Task m_tasks[SCHEDULER_CAPACITY];
+    size_t m_size;
+    bool m_running;
+    bool m_dirty;
+};
+
+#endif
@@ -4,7 +4,33 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include "LittleFS.h"
-
+#include "../KeyValueStore/KeyValueStore.h"
+
+#define STORAGE_KV_PATH "/kv/store.log"
+
+// writes within this window are coalesced into a single flush
+#ifndef STORAGE_COALESCE_MS
+#define STORAGE_COALESCE_MS 500
+#endif
+
+// a failed flush is retried after STORAGE_COALESCE_MS, doubled per failure up to this
+#ifndef STORAGE_FLUSH_BACKOFF_MAX_MS
+#define STORAGE_FLUSH_BACKOFF_MAX_MS 60000
+#endif
+
+/**
+ * JSON documents stored by path.
+ *
+ * The documents live in one shared append-only key-value store (the path
+ * is the key), an update appends a record instead of rewriting a file.
+ * A document that only exists as a file from an older firmware is still
+ * read, and only removed once its first write to the store is on flash.
+ *
+ * Writes are deferred: serve() (from the loop) flushes them once the
+ * oldest one is STORAGE_COALESCE_MS old, flush() forces it, e.g. before a
+ * reboot. Reads always see the latest value. A failed flush is logged,
+ * counted (getFlushFailures()) and retried with a backoff.
+ */
 class Storage {
 
 public:
@@ -24,9 +50,13 @@ public:
     {
         if (m_storagePath == "") {
             return false;
-        } else {
-            return p_fs->remove(m_storagePath);
         }
+
+        bool removed = store().remove(m_storagePath);
+        if (p_fs->exists(m_storagePath)) {
+            removed |= p_fs->remove(m_storagePath);
+        }
+        return removed;
     }
 
     template <class JsonBuffer>
@@ -34,9 +64,20 @@ public:
     {
         if (m_storagePath == "") {
             return jsonBuffer.createObject();
-        } else {
+        }
+
+        String value;
+        if (!store().get(m_storagePath, value)) {
+            // not migrated yet
             return Storage::loadJson(jsonBuffer, m_storagePath, p_logger, p_fs);
         }
+
+        JsonObject& jsonObjectRoot = jsonBuffer.parseObject(value);
+        if (!jsonObjectRoot.success()) {
+            p_logger->println("[Storage] invalid json: " + m_storagePath);
+            return jsonBuffer.createObject();
+        }
+        return jsonObjectRoot;
     }
 
     template <class JsonBuffer>
@@ -56,6 +97,7 @@ public:
         file.close();
 
         if (!jsonObjectRoot.success()) {
+            logger->println("[Storage] invalid json: " + path);
             return jsonBuffer.createObject();
         }
 
@@ -64,11 +106,78 @@ public:
 
     bool writeJson(JsonObject& jsonObject)
     {
-        if (m_storagePath == "") {
+        if (m_storagePath == "" || !jsonObject.success()) {
             return false;
-        } else {
-            return Storage::writeJson(jsonObject, m_storagePath, p_logger, p_fs);
         }
+
+        String value;
+        jsonObject.printTo(value);
+        if (!store().set(m_storagePath, value, true)) {
+            p_logger->println("[Storage] key-value store full: " + m_storagePath);
+            return false;
+        }
+
+        if (p_fs->exists(m_storagePath)) {
+            // the old file is the only copy on flash until the store is flushed
+            if (!flush(p_logger)) {
+                p_logger->println("[Storage] migration not flushed, keep: " + m_storagePath);
+                return true;
+            }
+            p_fs->remove(m_storagePath); // migrated
+        }
+        return true;
+    }
+
+    /**
+     * Write all deferred documents now.
+     */
+    static bool flush(Print *logger = &Serial)
+    {
+        FlushState& state = flushState();
+        if (store().flush()) {
+            state.backoffMs = 0;
+            return true;
+        }
+
+        state.failures++;
+        state.backoffMs = state.backoffMs ? min(state.backoffMs * 2, (unsigned long)STORAGE_FLUSH_BACKOFF_MAX_MS) : STORAGE_COALESCE_MS;
+        state.lastFailureMs = millis();
+        logger->println("[Storage] flush failed (" + String(state.failures) + "), retry in " + String(state.backoffMs) + " ms");
+        return false;
+    }
+
+    /**
+     * Flush the deferred documents once the coalesce window passed,
+     * after a failed flush once its backoff passed.
+     */
+    static void serve(Print *logger = &Serial)
+    {
+        KeyValueStore& kvStore = store();
+        const FlushState& state = flushState();
+        if (!kvStore.isPending() || millis() - kvStore.getPendingSinceMs() < STORAGE_COALESCE_MS) {
+            return;
+        }
+        if (state.backoffMs && millis() - state.lastFailureMs < state.backoffMs) {
+            return;
+        }
+        flush(logger);
+    }
+
+    /**
+     * @return amount of failed flushes since boot
+     */
+    static uint32_t getFlushFailures()
+    {
+        return flushState().failures;
+    }
+
+    /**
+     * Shared by all storage instances.
+     */
+    static KeyValueStore& store()
+    {
+        static KeyValueStore kvStore(STORAGE_KV_PATH);
+        return kvStore;
     }
 
     static bool writeJson(JsonObject& jsonObject, String path, Print *logger = &Serial, FS *fs = &LittleFS)
@@ -77,7 +186,9 @@ public:
             return false;
         }
 
-        File file = fs->open(path, "w");
+        // stage to a temp file, the rename replaces the old file at once
+        String tmpPath = path + ".tmp";
+        File file = fs->open(tmpPath, "w");
         if (!file) {
             logger->println("[Storage] file open failed");
             return false;
@@ -85,14 +196,31 @@ public:
 
         if (!jsonObject.printTo(file)) {
             file.close();
+            fs->remove(tmpPath);
             return false;
         }
 
         file.close();
+        if (!fs->rename(tmpPath, path)) {
+            fs->remove(tmpPath);
+            return false;
+        }
         return true;
     }
 
 private:
+    struct FlushState {
+        uint32_t failures = 0;
+        unsigned long backoffMs = 0; // 0: the last flush succeeded
+        unsigned long lastFailureMs = 0;
+    };
+
+    static FlushState& flushState()
+    {
+        static FlushState state;
+        return state;
+    }
+
     void begin() {
         p_fs->begin();
     }
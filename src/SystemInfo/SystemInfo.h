@@ -0,0 +1,177 @@
+#ifndef SystemInfo_h
+#define SystemInfo_h
+
+#include <Arduino.h>
+
+/**
+ * Body of /api/systeminfo.
+ *
+ * Everything that can't change after boot (chip, flash, versions, reset
+ * info, sketch md5, boot count) is read once in begin(), a request only
+ * reads the dynamic values: heap, voltage, cycle count, uptime and the
+ * state that's owned by the firmware (Runtime).
+ *
+ * The fields filter is a comma separated list of field names, "static" and
+ * "dynamic" select the whole group, empty (default) selects all fields.
+ *
+ * @tparam Writer: JsonWriter or CborWriter
+ *
+ * ussage e.g.:
+ * systemInfo.begin(bootCount, "SmartHue-5a3c1e", board::NAME, board::RELAY_COUNT);
+ * SystemInfo::Runtime runtime;
+ * runtime.rssi = WiFi.RSSI();
+ * systemInfo.printTo(json, runtime, "dynamic");
+ */
+class SystemInfo {
+public:
+    struct Runtime {
+        float loopFrequency = 0;
+        uint32_t logDropped = 0;
+        size_t logQueueHighWater = 0;
+        String ipAddress;
+        int32_t rssi = 0;
+    };
+
+    void begin(int bootCount, const char* deviceId, const char* board, uint8_t relayCount)
+    {
+        m_static.chipId = ESP.getChipId();
+        m_static.bootMode = ESP.getBootMode();
+        m_static.bootVersion = ESP.getBootVersion();
+        m_static.bootCount = bootCount;
+        m_static.coreVersion = ESP.getCoreVersion();
+        m_static.cpuFreqMHz = ESP.getCpuFreqMHz();
+        m_static.flashChipId = ESP.getFlashChipId();
+        m_static.flashChipMode = ESP.getFlashChipMode();
+        m_static.flashChipRealSize = ESP.getFlashChipRealSize();
+        m_static.flashChipSize = ESP.getFlashChipSize();
+        m_static.flashChipSizeByChipId = ESP.getFlashChipSizeByChipId();
+        m_static.flashChipSpeed = ESP.getFlashChipSpeed();
+        m_static.freeSketchSpace = ESP.getFreeSketchSpace();
+        m_static.resetInfo = ESP.getResetInfo();
+        m_static.resetInfoPtr = *ESP.getResetInfoPtr();
+        m_static.resetReason = ESP.getResetReason();
+        m_static.sdkVersion = ESP.getSdkVersion();
+        m_static.sketchMd5 = ESP.getSketchMD5();
+        m_static.sketchSize = ESP.getSketchSize();
+        m_static.deviceId = deviceId;
+        m_static.board = board;
+        m_static.relayCount = relayCount;
+    }
+
+    template <class Writer>
+    void printTo(Writer& json, const Runtime& runtime, const char* fields = nullptr) const
+    {
+        const Static& s = m_static;
+        json.beginObject();
+        set(json, fields, true, F("chip_id"), s.chipId);
+        if (selected(fields, false, F("power_voltage"))) {
+            json.set(F("power_voltage"), (float)ESP.getVcc() / 1024.00f);
+        }
+        set(json, fields, true, F("boot_mode"), s.bootMode);
+        set(json, fields, true, F("boot_version"), s.bootVersion);
+        set(json, fields, true, F("boot_count"), s.bootCount);
+        set(json, fields, true, F("core_version"), s.coreVersion);
+        set(json, fields, true, F("cpu_freq_mhz"), s.cpuFreqMHz);
+        if (selected(fields, false, F("cycle_count"))) {
+            json.set(F("cycle_count"), ESP.getCycleCount());
+        }
+        set(json, fields, true, F("flash_chip_id"), s.flashChipId);
+        set(json, fields, true, F("flash_chip_mode"), s.flashChipMode);
+        set(json, fields, true, F("flash_chip_real_size"), s.flashChipRealSize);
+        set(json, fields, true, F("flash_chip_size"), s.flashChipSize);
+        set(json, fields, true, F("flash_chip_size_by_chip_id"), s.flashChipSizeByChipId);
+        set(json, fields, true, F("flash_chip_speed"), s.flashChipSpeed);
+        if (selected(fields, false, F("free_heap"))) {
+            json.set(F("free_heap"), ESP.getFreeHeap());
+        }
+        if (selected(fields, false, F("max_free_block_size"))) {
+            json.set(F("max_free_block_size"), ESP.getMaxFreeBlockSize());
+        }
+        if (selected(fields, false, F("heap_fragmentation"))) {
+            json.set(F("heap_fragmentation"), ESP.getHeapFragmentation());
+        }
+        set(json, fields, true, F("free_sketch_space"), s.freeSketchSpace);
+        set(json, fields, true, F("reset_info"), s.resetInfo);
+        set(json, fields, true, F("reset_info_depc"), s.resetInfoPtr.depc);
+        set(json, fields, true, F("reset_info_epc1"), s.resetInfoPtr.epc1);
+        set(json, fields, true, F("reset_info_epc2"), s.resetInfoPtr.epc2);
+        set(json, fields, true, F("reset_info_epc3"), s.resetInfoPtr.epc3);
+        set(json, fields, true, F("reset_info_exccause"), s.resetInfoPtr.exccause);
+        set(json, fields, true, F("reset_info_excvaddr"), s.resetInfoPtr.excvaddr);
+        set(json, fields, true, F("reset_info_reason"), s.resetInfoPtr.reason);
+        set(json, fields, true, F("reset_reason"), s.resetReason);
+        set(json, fields, true, F("sdk_version"), s.sdkVersion);
+        set(json, fields, true, F("sketch_md5"), s.sketchMd5);
+        set(json, fields, true, F("sketch_size"), s.sketchSize);
+        set(json, fields, false, F("loop_freq_mhz"), runtime.loopFrequency);
+        set(json, fields, false, F("log_dropped"), runtime.logDropped);
+        set(json, fields, false, F("log_queue_high_water"), runtime.logQueueHighWater);
+        set(json, fields, false, F("ip_address"), runtime.ipAddress);
+        set(json, fields, true, F("device_id"), s.deviceId);
+        set(json, fields, true, F("board"), s.board);
+        set(json, fields, true, F("relay_count"), s.relayCount);
+        if (selected(fields, false, F("uptime"))) {
+            json.set(F("uptime"), millis() / 1000);
+        }
+        set(json, fields, false, F("rssi"), runtime.rssi);
+        json.endObject();
+    }
+
+private:
+    struct Static {
+        uint32_t chipId = 0;
+        uint8_t bootMode = 0;
+        uint8_t bootVersion = 0;
+        int bootCount = 0;
+        String coreVersion;
+        uint8_t cpuFreqMHz = 0;
+        uint32_t flashChipId = 0;
+        uint32_t flashChipMode = 0;
+        uint32_t flashChipRealSize = 0;
+        uint32_t flashChipSize = 0;
+        uint32_t flashChipSizeByChipId = 0;
+        uint32_t flashChipSpeed = 0;
+        uint32_t freeSketchSpace = 0;
+        String resetInfo;
+        rst_info resetInfoPtr = {};
+        String resetReason;
+        const char* sdkVersion = "";
+        String sketchMd5;
+        uint32_t sketchSize = 0;
+        const char* deviceId = "";
+        const char* board = "";
+        uint8_t relayCount = 0;
+    };
+
+    template <class Writer, typename Value>
+    static void set(Writer& json, const char* fields, bool isStatic, const __FlashStringHelper* name, const Value& value)
+    {
+        if (selected(fields, isStatic, name)) {
+            json.set(name, value);
+        }
+    }
+
+    static bool selected(const char* fields, bool isStatic, const __FlashStringHelper* name)
+    {
+        if (!fields || !*fields) {
+            return true;
+        }
+
+        PGM_P p = reinterpret_cast<PGM_P>(name);
+        while (*fields) {
+            const char* end = strchr(fields, ',');
+            size_t length = end ? (size_t)(end - fields) : strlen(fields);
+            if ((length == 6 && !strncmp(fields, "static", length) && isStatic)
+                || (length == 7 && !strncmp(fields, "dynamic", length) && !isStatic)
+                || (!strncmp_P(fields, p, length) && !pgm_read_byte(p + length))) {
+                return true;
+            }
+            fields += end ? length + 1 : length;
+        }
+        return false;
+    }
+
+    Static m_static;
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef UdpControl_h
+#define UdpControl_h
+
+#include <Arduino.h>
+#include <bearssl/bearssl.h>
+
+#define UDP_CONTROL_VERSION 1
+#define UDP_CONTROL_MAC_SIZE 16
+
+/**
+ * Authenticated binary frames for the UDP relay control channel.
+ *
+ * Requests and acks share one fixed 36 byte little endian layout, the
+ * magic tells them apart so an ack can't be reflected as a request.
+ * Every frame ends with a truncated HMAC-SHA256 over the bytes before it,
+ * keyed with HMAC-SHA256(secret, "SmartHue-udp:" + user).
+ *
+ * Replay protection: a request must carry the nonce that was picked at
+ * boot and a sequence number above the last accepted one. A request with
+ * a stale nonce or sequence number is answered with the current nonce and
+ * the last accepted sequence number, so the client can resync.
+ * Frames with a bad MAC are dropped without an answer.
+ *
+ * ussage e.g.:
+ * UdpControl control(pass::WWW_USER, pass::WWW_PASS);
+ * control.begin(ESP.random());
+ * UdpControl::Status status = control.verify(request);
+ * control.sign(ack, request, status, relayState);
+ */
+class UdpControl {
+public:
+    enum Op : uint8_t {
+        OP_OFF,
+        OP_ON,
+        OP_TOGGLE,
+        OP_STATE, // only report the relay state
+    };
+
+    enum Status : uint8_t {
+        STATUS_OK,
+        STATUS_NONCE, // unknown nonce, the device rebooted
+        STATUS_REPLAY, // sequence number already used
+        STATUS_INVALID, // not a frame or bad mac, never answered
+    };
+
+    struct __attribute__((packed)) Frame {
+        uint8_t magic[2]; // "SQ" request, "SA" ack
+        uint8_t version;
+        uint8_t code; // request: Op, ack: Status
+        uint16_t mask; // request: relays to switch, ack: relay state, bit 0 is relay 1
+        uint16_t reserved;
+        uint32_t nonce;
+        uint32_t seq;
+        uint32_t timestamp; // client time, echoed in the ack
+        uint8_t mac[UDP_CONTROL_MAC_SIZE];
+    };
+
+    UdpControl(const char* user, const char* secret)
+        : m_nonce(0)
+        , m_lastSeq(0)
+    {
+        static const char context[] = "SmartHue-udp:";
+        br_hmac_key_context keyContext;
+        br_hmac_key_init(&keyContext, &br_sha256_vtable, secret, strlen(secret));
+        br_hmac_context hmac;
+        br_hmac_init(&hmac, &keyContext, 0);
+        br_hmac_update(&hmac, context, strlen(context));
+        br_hmac_update(&hmac, user, strlen(user));
+        br_hmac_out(&hmac, m_key);
+    }
+
+    /**
+     * Start a new session, all earlier frames become invalid.
+     */
+    void begin(uint32_t nonce)
+    {
+        m_nonce = nonce;
+        m_lastSeq = 0;
+    }
+
+    Status verify(const Frame& request)
+    {
+        if (request.magic[0] != 'S' || request.magic[1] != 'Q' || request.version != UDP_CONTROL_VERSION
+            || request.code > OP_STATE) {
+            return STATUS_INVALID;
+        }
+
+        uint8_t mac[UDP_CONTROL_MAC_SIZE];
+        computeMac(request, mac);
+        uint8_t diff = 0; // constant time compare
+        for (size_t i = 0; i < UDP_CONTROL_MAC_SIZE; i++) {
+            diff |= mac[i] ^ request.mac[i];
+        }
+        if (diff) {
+            return STATUS_INVALID;
+        }
+
+        if (request.nonce != m_nonce) {
+            return STATUS_NONCE;
+        }
+        if (request.seq <= m_lastSeq) {
+            return STATUS_REPLAY;
+        }
+
+        m_lastSeq = request.seq;
+        return STATUS_OK;
+    }
+
+    void sign(Frame& ack, const Frame& request, Status status, uint16_t state) const
+    {
+        ack.magic[0] = 'S';
+        ack.magic[1] = 'A';
+        ack.version = UDP_CONTROL_VERSION;
+        ack.code = status;
+        ack.mask = state;
+        ack.reserved = 0;
+        ack.nonce = m_nonce;
+        ack.seq = status == STATUS_OK ? request.seq : m_lastSeq;
+        ack.timestamp = request.timestamp;
+        computeMac(ack, ack.mac);
+    }
+
+    uint32_t getLastSeq() const
+    {
+        return m_lastSeq;
+    }
+
+private:
+    void computeMac(const Frame& frame, uint8_t* mac) const
+    {
+        uint8_t out[br_sha256_SIZE];
+        br_hmac_key_context keyContext;
+        br_hmac_key_init(&keyContext, &br_sha256_vtable, m_key, sizeof(m_key));
+        br_hmac_context hmac;
+        br_hmac_init(&hmac, &keyContext, 0);
+        br_hmac_update(&hmac, &frame, offsetof(Frame, mac));
+        br_hmac_out(&hmac, out);
+        memcpy(mac, out, UDP_CONTROL_MAC_SIZE);
+    }
+
+    uint8_t m_key[br_sha256_SIZE];
+    uint32_t m_nonce;
+    uint32_t m_lastSeq;
+};
+
+#endif
@@ -1,5 +1,17 @@
+#include "Board/Board.h"
+#include "CborReader/CborReader.h"
+#include "CborWriter/CborWriter.h"
+#include "ChunkedResponse/ChunkedResponse.h"
 #include "Config/Config.h"
+#include "EventStream/EventStream.h"
+#include "JsonWriter/JsonWriter.h"
+#include "Metrics/Metrics.h"
+#include "RequestArena/RequestArena.h"
+#include "RequestBody/RequestBody.h"
+#include "Scheduler/Scheduler.h"
 #include "Storage/Storage.h"
+#include "SystemInfo/SystemInfo.h"
+#include "UdpControl/UdpControl.h"
 #include <ArduinoExtension.h>
 #include <ArduinoJson.h>
 #include <ArduinoOTA.h>
@@ -10,6 +22,8 @@
 #include <ESP8266mDNS.h>
 #include <FS.h>
 #include <Logger.h>
+#include <PubSubClient.h>
+#include <StreamString.h>
 #include <Syslog.h>
 #include <Ticker.h>
 #include <build/version.h>
@@ -22,6 +36,8 @@ bool setupOTA();
 bool setupWiFi(int timeoutConfigAp = 1000 * 600, int timeoutConnection = 1000 * 120);
 bool beginWiFi();
 bool reconnectWiFi(bool force = false);
+void applyWiFiConfig();
+bool setupSyslog();
 
 void setupConfigAp();
 void resetConfigAp();
@@ -33,9 +49,18 @@ void serveDnsServer();
 void setupMDNS();
 void serveMDNS();
 
+void drainLogQueue();
+
+void setupUdpControl();
+void serveUdpControl();
+
+void setupMqtt();
+void serveMqtt();
+
 void setupWebServer();
 void resetWebServer();
 void serveWebServer();
+void serveEvents();
 
 const String deviceId = "SmartHue-" + String(ESP.getChipId(), HEX);
 const String repoUrl = "https://github.com/ThomasDevoogdt/SmartHue";
@@ -55,41 +80,160 @@ const String repoUrl = "https://github.com/ThomasDevoogdt/SmartHue";
 #define WWW_USER pass::WWW_USER
 #define WWW_PASS pass::WWW_PASS
 
+// time the log queue drain may take per loop pass
+#ifndef LOG_DRAIN_BUDGET_US
+#define LOG_DRAIN_BUDGET_US 2000
+#endif
+
+// time budgets of the heavy loop tasks, a call over budget counts as overrun in /api/profile
+// webserver: a request on a resumed TLS session, a full handshake is an overrun
+#ifndef WEB_SERVER_BUDGET_US
+#define WEB_SERVER_BUDGET_US 100000
+#endif
+// mqtt: a loop() pass, a (re)connect attempt is an overrun
+#ifndef MQTT_BUDGET_US
+#define MQTT_BUDGET_US 20000
+#endif
+// log: the drain stops after LOG_DRAIN_BUDGET_US, plus the line that's being sent
+#ifndef LOG_BUDGET_US
+#define LOG_BUDGET_US (2 * LOG_DRAIN_BUDGET_US)
+#endif
+// storage: one flush of the key-value store to LittleFS
+#ifndef STORAGE_BUDGET_US
+#define STORAGE_BUDGET_US 50000
+#endif
+
+// give the response to /api/config some time to leave before the wifi connection restarts
+#define WIFI_CONFIG_APPLY_DELAY_MS 1000
+
+// amount of resumable TLS sessions, each one costs about 100 bytes of heap
+#ifndef TLS_SESSION_CACHE_SIZE
+#define TLS_SESSION_CACHE_SIZE 4
+#endif
+
+// persistent connections, the server only serves one client at a time,
+// so an idle connection is closed quickly to let the next client in
+#ifndef WEB_KEEP_ALIVE_IDLE_MS
+#define WEB_KEEP_ALIVE_IDLE_MS 2000
+#endif
+#ifndef WEB_KEEP_ALIVE_MAX_REQUESTS
+#define WEB_KEEP_ALIVE_MAX_REQUESTS 32
+#endif
+
+// request bodies are parsed in place from one fixed buffer, a larger body gets a 413
+#ifndef WEB_MAX_BODY_SIZE
+#define WEB_MAX_BODY_SIZE 1024
+#endif
+
+// authenticated udp relay control, 0 disables the listener
+#ifndef UDP_CONTROL_PORT
+#define UDP_CONTROL_PORT 4210
+#endif
+
+// mqtt, the client only runs when an mqtt ip is configured
+#define MQTT_TOPIC_PREFIX "smarthue/"
+#define MQTT_CONNECT_TIMEOUT_MS 1000
+#define MQTT_BACKOFF_MIN_MS 1000
+#define MQTT_BACKOFF_MAX_MS 60000
+#ifndef MQTT_TELEMETRY_INTERVAL_MS
+#define MQTT_TELEMETRY_INTERVAL_MS 60000
+#endif
+
+// /api/events, comment frame to every subscriber and metrics frame to the ones that asked for it
+#ifndef EVENTS_HEARTBEAT_MS
+#define EVENTS_HEARTBEAT_MS 15000
+#endif
+#ifndef EVENTS_METRICS_MS
+#define EVENTS_METRICS_MS 10000
+#endif
+
 #define LOCAL_IP IPAddress(10, 0, 1, 1)
 #define GATEWAY_IP IPAddress(10, 0, 1, 1)
 #define SUBNET_IP IPAddress(255, 255, 255, 0)
 
+typedef ChunkedResponse<BearSSL::ESP8266WebServerSecure> WebResponse;
+typedef EventStream<BearSSL::WiFiClientSecure> WebEvents;
+
+struct MqttState {
+    String topic; // MQTT_TOPIC_PREFIX + device id
+    String host; // PubSubClient only keeps a pointer to it
+    int port = 0;
+    unsigned long backoffMs = 0; // 0: connect immediately
+    unsigned long lastAttemptMs = 0;
+    unsigned long lastTelemetryMs = 0;
+    uint16_t dirty = 0; // relays of which the state must be published
+};
+
+struct WebConnection {
+    IPAddress ip;
+    uint16_t port = 0;
+    uint16_t requests = 0;
+    unsigned long lastRequestMs = 0;
+};
+
 unsigned long loopLastTime = micros();
 float loopFrequency = 0;
+int bootCount = 0;
+uint32_t stateGeneration = 0; // incremented on every relay change, /api/state ETag
 
 class GlobalVar {
 public:
     GlobalVar() :
         logger(LOG_ID),
         config(&logger),
+        udpControl(WWW_USER, WWW_PASS),
+        mqtt(mqttWifiClient),
         bootTimeStorage("/tmp/boot.json", &logger),
         otaLogStorage("/tmp/ota.json", &logger) {}
 
     Logger logger;
     Config config;
+    Metrics metrics;
+    SystemInfo systemInfo;
     Ticker ticker;
 
     std::unique_ptr<DNSServer> dnsServer;
     std::unique_ptr<BearSSL::ESP8266WebServerSecure> server;
+    std::unique_ptr<BearSSL::ServerSessions> tlsSessions;
+    WebConnection webConnection;
+    WebEvents events;
+    RequestBody<WEB_MAX_BODY_SIZE> requestBody;
 
     WiFiUDP syslogUdpClient;
     std::unique_ptr<Syslog> syslog;
 
-    LinkedList<void (*)()> loopList;
+    WiFiUDP udpControlClient;
+    UdpControl udpControl;
+
+    WiFiClient mqttWifiClient;
+    PubSubClient mqtt;
+    MqttState mqttState;
+
+    Scheduler scheduler;
 
     Storage bootTimeStorage;
     Storage otaLogStorage;
 } *p_var;
 
-// relay board pins
-const uint8_t pins_arr[2] = { D6, D7 };
+#define RELAY_BATCH_MAX 16
+
+// parse arenas of the POST routes, a body with more members doesn't parse
+#define SET_JSON_BUFFER_SIZE (JSON_ARRAY_SIZE(RELAY_BATCH_MAX) + RELAY_BATCH_MAX * JSON_OBJECT_SIZE(2))
+#define CONFIG_JSON_BUFFER_SIZE (JSON_OBJECT_SIZE(4) + 3 * JSON_OBJECT_SIZE(2))
+
+struct RelayOp {
+    enum Value : uint8_t {
+        OFF,
+        ON,
+        TOGGLE,
+    };
+
+    uint8_t relay;
+    Value value;
+};
 
 bool tryWiFiReconnect = false;
+unsigned long wifiConfigChangedMs = 0;
 
 String macToString(const uint8 *mac) {
   char buf[20];
@@ -112,11 +256,9 @@ void tick()
 void callLoopList(unsigned long delay = 0)
 {
     doWhileLoopDelay(delay, []() {
-        auto &loopList = p_var->loopList;
-        // execute all registered loop callbacks
-        for (int i = 0; i < loopList.size(); i++) {
-            (loopList.get(i))();
-        }
+        auto &scheduler = p_var->scheduler;
+        // execute all registered loop callbacks that are due
+        scheduler.run();
 
         // loop freqency statistics
         unsigned long timeDiff = micros() - loopLastTime;
@@ -127,78 +269,206 @@ void callLoopList(unsigned long delay = 0)
     });
 }
 
-void setLoopListCb(void (*cb)())
+/**
+ * Register a loop callback
+ *
+ * @param cb: callback function
+ * @param name: task name, used for profiling
+ * @param periodMs: minimum time between two calls, 0: every loop iteration
+ * @param priority: Scheduler::PRIORITY_HIGH ... Scheduler::PRIORITY_LOW
+ * @param ready: optional condition, the callback only runs if it returns true
+ * @param budgetUs: expected max execution time, 0: no budget
+ */
+void setLoopListCb(void (*cb)(), const char* name = nullptr, unsigned long periodMs = 0, uint8_t priority = Scheduler::PRIORITY_NORMAL,
+    bool (*ready)() = nullptr, unsigned long budgetUs = 0)
 {
-    auto &loopList = p_var->loopList;
-    for (int i = 0; i < loopList.size(); i++) {
-        if (loopList.get(i) == cb) {
-            return;
-        }
+    auto &logger = p_var->logger;
+    auto &scheduler = p_var->scheduler;
+    if (!scheduler.add(cb, name, periodMs, priority, ready, budgetUs)) {
+        LOGGER_ERROR(logger, F("[Scheduler] no free task slot"));
     }
-    loopList.add(cb);
 }
 
 void removeLoopListCb(void (*cb)())
 {
-    auto &loopList = p_var->loopList;
-    for (int i = 0; i < loopList.size(); i++) {
-        if (loopList.get(i) == cb) {
-            loopList.remove(i);
-            return;
-        }
-    }
+    auto &scheduler = p_var->scheduler;
+    scheduler.remove(cb);
 }
 
 void clearLoopListCb()
 {
-    auto &loopList = p_var->loopList;
-    loopList.clear();
+    auto &scheduler = p_var->scheduler;
+    scheduler.clear();
 }
 
-bool setPin(JsonObject& jsonRoot)
+/**
+ * Parse a single relay operation: {"relay": 1, "value": true} sets the relay,
+ * {"relay": 1} or {"relay": 1, "op": "toggle"} toggles it.
+ */
+bool parseRelayOp(JsonObject& jsonOp, RelayOp& op)
 {
     auto &logger = p_var->logger;
-    if (!jsonRoot.success()) {
-        logger.log("[SetPin] parseObject() failed", Logger::ERROR);
+    if (!jsonOp.success()) {
+        LOGGER_ERROR(logger, "[SetPin] parseObject() failed");
         return false;
     }
 
-    if (!jsonRoot.containsKey("relay") || !jsonRoot["relay"].is<int>()
-        || (jsonRoot.containsKey("value")
-               && (!(jsonRoot["value"].is<int>() || jsonRoot["value"].is<bool>())))) {
-        logger.log("[SetPin] The keys \"relay\" (int) and \"value\" (int/bool) are not provided.", Logger::ERROR);
+    if (!jsonOp.containsKey("relay") || !jsonOp["relay"].is<int>()
+        || (jsonOp.containsKey("value")
+               && (!(jsonOp["value"].is<int>() || jsonOp["value"].is<bool>())))) {
+        LOGGER_ERROR(logger, "[SetPin] The keys \"relay\" (int) and \"value\" (int/bool) are not provided.");
         return false;
     }
 
-    uint8_t relay, pin, value;
-
-    // relay to pin
-    relay = (uint8_t)jsonRoot["relay"];
-    switch (relay) {
-    case 1:
-        pin = pins_arr[0];
-        break;
-    case 2:
-        pin = pins_arr[1];
-        break;
-    default:
+    op.relay = (uint8_t)jsonOp["relay"];
+    if (!board::relay(op.relay)) {
+        LOGGER_ERROR(logger, "[SetPin] unknown relay " + String(op.relay));
         return false;
     }
 
-    // get new value
-    if (jsonRoot.containsKey("value")) {
-        if (jsonRoot["value"].is<int>()) {
-            value = (uint8_t)jsonRoot["value"].as<int>();
+    const char* action = jsonOp["op"] | (jsonOp.containsKey("value") ? "set" : "toggle");
+    if (!strcmp(action, "toggle")) {
+        op.value = RelayOp::TOGGLE;
+    } else if (!strcmp(action, "set") && jsonOp.containsKey("value")) {
+        if (jsonOp["value"].is<int>()) {
+            op.value = jsonOp["value"].as<int>() ? RelayOp::ON : RelayOp::OFF;
         } else {
-            value = (uint8_t)jsonRoot["value"].as<bool>();
+            op.value = jsonOp["value"].as<bool>() ? RelayOp::ON : RelayOp::OFF;
         }
     } else {
-        value = !digitalRead(pin);
+        LOGGER_ERROR(logger, "[SetPin] unknown op \"" + String(action) + "\" for relay " + String(op.relay));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Current state of every relay, bit 0 is relay 1.
+ */
+uint16_t getRelayState()
+{
+    uint16_t state = 0;
+    for (uint8_t i = 0; i < board::RELAY_COUNT; i++) {
+        if (board::isOn(board::relays[i])) {
+            state |= 1U << i;
+        }
+    }
+    return state;
+}
+
+/**
+ * Json data of a relay event, {"relay":1,"value":true}, index 0 is relay 1.
+ */
+void formatRelayEvent(char* buffer, size_t size, uint8_t index)
+{
+    snprintf(buffer, size, "{\"relay\":%u,\"value\":%s}", index + 1, board::isOn(board::relays[index]) ? "true" : "false");
+}
+
+/**
+ * Called after the relays in the mask changed state,
+ * bit 0 is relay 1.
+ */
+void onRelayChange(uint16_t changed)
+{
+    auto &mqttState = p_var->mqttState;
+    auto &events = p_var->events;
+    mqttState.dirty |= changed;
+    stateGeneration++;
+
+    for (uint8_t i = 0; i < board::RELAY_COUNT; i++) {
+        if (changed & (1U << i)) {
+            char data[32];
+            formatRelayEvent(data, sizeof(data), i);
+            events.publish(WebEvents::TOPIC_RELAY, "relay", data);
+        }
     }
+}
 
-    logger.log("[SetPin] " + String(value ? "Open" : "Close") + " relay " + String(relay) + " (GPIO: " + String(pin) + ")");
-    pinMode(pin, OUTPUT);
-    digitalWrite(pin, value);
+/**
+ * Apply already validated relay operations in one step, the GPIO 0..15
+ * outputs all change with a single write of the GPO register.
+ */
+void applyRelayOps(const RelayOp* ops, size_t count)
+{
+    auto &logger = p_var->logger;
+    auto &metrics = p_var->metrics;
+
+    // resolve the new state of every relay first
+    bool state[board::RELAY_COUNT];
+    bool touched[board::RELAY_COUNT] = {};
+    for (uint8_t i = 0; i < board::RELAY_COUNT; i++) {
+        state[i] = board::isOn(board::relays[i]);
+    }
+    for (size_t i = 0; i < count; i++) {
+        uint8_t index = ops[i].relay - 1;
+        state[index] = ops[i].value == RelayOp::TOGGLE ? !state[index] : ops[i].value == RelayOp::ON;
+        touched[index] = true;
+    }
+
+    uint32_t setMask = 0, clearMask = 0;
+    uint16_t changed = 0;
+    for (uint8_t i = 0; i < board::RELAY_COUNT; i++) {
+        if (!touched[i]) {
+            continue;
+        }
+
+        const RelayConfig& relay = board::relays[i];
+        uint8_t level = board::level(relay, state[i]);
+        LOGGER_INFO(logger, "[SetPin] " + String(state[i] ? "Open" : "Close") + " relay " + String(i + 1) + " (GPIO: " + String(relay.pin) + ")");
+        if (board::isOn(relay) != state[i]) {
+            metrics.countRelayToggle(i + 1);
+            changed |= 1U << i;
+        }
+
+        pinMode(relay.pin, OUTPUT);
+        if (relay.pin < 16) {
+            (level ? setMask : clearMask) |= 1UL << relay.pin;
+        } else {
+            digitalWrite(relay.pin, level);
+        }
+    }
+
+    if (setMask || clearMask) {
+        GPO = (GPO & ~clearMask) | setMask;
+    }
+
+    if (changed) {
+        onRelayChange(changed);
+    }
+}
+
+bool setPin(JsonObject& jsonRoot)
+{
+    RelayOp op;
+    if (!parseRelayOp(jsonRoot, op)) {
+        return false;
+    }
+
+    applyRelayOps(&op, 1);
+    return true;
+}
+
+/**
+ * All operations are validated before any relay is switched,
+ * one invalid operation rejects the whole batch.
+ */
+bool setPins(JsonArray& jsonRoot)
+{
+    auto &logger = p_var->logger;
+    if (!jsonRoot.success() || !jsonRoot.size() || jsonRoot.size() > RELAY_BATCH_MAX) {
+        LOGGER_ERROR(logger, "[SetPin] expected an array of 1 to " + String(RELAY_BATCH_MAX) + " relay operations");
+        return false;
+    }
+
+    RelayOp ops[RELAY_BATCH_MAX];
+    size_t count = 0;
+    for (JsonVariant jsonOp : jsonRoot) {
+        if (!parseRelayOp(jsonOp.as<JsonObject>(), ops[count++])) {
+            return false;
+        }
+    }
+
+    applyRelayOps(ops, count);
     return true;
 }
 
@@ -206,48 +476,40 @@ bool getPin(JsonObject& jsonRoot)
 {
     auto &logger = p_var->logger;
     if (!jsonRoot.success()) {
-        logger.log("[GetPin] parseObject() failed", Logger::ERROR);
+        LOGGER_ERROR(logger, "[GetPin] parseObject() failed");
         return false;
     }
 
     if (!jsonRoot.containsKey("relay")
         || !jsonRoot["relay"].is<int>()) {
-        logger.log("[SetPin] The key \"relay\" (int) is not provided.", Logger::ERROR);
+        LOGGER_ERROR(logger, "[SetPin] The key \"relay\" (int) is not provided.");
         return false;
     }
 
-    uint8_t relay, pin;
-    relay = (uint8_t)jsonRoot["relay"];
-    switch (relay) {
-    case 1:
-        pin = pins_arr[0];
-        break;
-    case 2:
-        pin = pins_arr[1];
-        break;
-    default:
+    const RelayConfig* relay = board::relay((uint8_t)jsonRoot["relay"]);
+    if (!relay) {
         return false;
     }
 
-    jsonRoot.set("value", (bool)digitalRead(pin));
+    jsonRoot.set("value", board::isOn(*relay));
     return true;
 }
 
 void showSystemInfo()
 {
     auto &logger = p_var->logger;
-    logger.log("[sysinfo] system build date: " + String(__DATE__));
-    logger.log("[sysinfo] system build time: " + String(__TIME__));
-    logger.log("[sysinfo] system version: " + String(version::VERSION_STRING));
-    logger.log("[sysinfo] system commit id: " + String(version::GIT_COMMIT_ID));
+    LOGGER_INFO(logger, "[sysinfo] system build date: " + String(__DATE__));
+    LOGGER_INFO(logger, "[sysinfo] system build time: " + String(__TIME__));
+    LOGGER_INFO(logger, "[sysinfo] system version: " + String(version::VERSION_STRING));
+    LOGGER_INFO(logger, "[sysinfo] system commit id: " + String(version::GIT_COMMIT_ID));
 }
 
 void showConfig()
 {
     auto &logger = p_var->logger;
     auto &config = p_var->config;
-    logger.log("[config] load config");
-    logger.log("[config] version: " + config.getConfigVersion());
+    LOGGER_INFO(logger, "[config] load config");
+    LOGGER_INFO(logger, "[config] version: " + config.getConfigVersion());
 
     String wifi_ssid, wifi_pass;
     config.getWifiConfig(wifi_ssid, wifi_pass);
@@ -255,32 +517,38 @@ void showConfig()
     for (size_t i = 1; i < wifi_pass.length(); i++) {
         wifi_mask += '*';
     }
-    logger.log("[config] wifi ssid: " + wifi_ssid);
-    logger.log("[config] wifi pass: " + wifi_mask);
+    LOGGER_INFO(logger, "[config] wifi ssid: " + wifi_ssid);
+    LOGGER_INFO(logger, "[config] wifi pass: " + wifi_mask);
 
     String syslog_server;
     int syslog_port;
     config.getSyslogConfig(syslog_server, syslog_port);
-    logger.log("[config] syslog ip: " + syslog_server);
-    logger.log("[config] syslog port: " + String(syslog_port));
+    LOGGER_INFO(logger, "[config] syslog ip: " + syslog_server);
+    LOGGER_INFO(logger, "[config] syslog port: " + String(syslog_port));
+
+    String mqtt_server;
+    int mqtt_port;
+    config.getMqttConfig(mqtt_server, mqtt_port);
+    LOGGER_INFO(logger, "[config] mqtt ip: " + mqtt_server);
+    LOGGER_INFO(logger, "[config] mqtt port: " + String(mqtt_port));
 }
 
 void setupDnsServer()
 {
     auto &logger = p_var->logger;
     auto &dnsServer = p_var->dnsServer;
-    logger.log("[Setup DNS server]");
+    LOGGER_INFO(logger, "[Setup DNS server]");
     dnsServer.reset(new DNSServer());
     dnsServer->setErrorReplyCode(DNSReplyCode::NoError);
     dnsServer->start(53, "*", LOCAL_IP);
-    setLoopListCb(serveDnsServer);
+    setLoopListCb(serveDnsServer, "dns", 0, Scheduler::PRIORITY_HIGH);
 }
 
 void resetDnsServer()
 {
     auto &logger = p_var->logger;
     auto &dnsServer = p_var->dnsServer;
-    logger.log("[Reset DNS server]");
+    LOGGER_INFO(logger, "[Reset DNS server]");
     dnsServer.reset();
     removeLoopListCb(serveDnsServer);
 }
@@ -291,19 +559,201 @@ void serveDnsServer()
     dnsServer->processNextRequest();
 }
 
+/**
+ * Run the handler of a route, every request is measured in the metrics
+ */
+void serveRoute(int route, void (*handler)())
+{
+    auto &server = p_var->server;
+    auto &metrics = p_var->metrics;
+    auto &connection = p_var->webConnection;
+    WiFiClient &client = server->client();
+    if (client.remotePort() != connection.port || client.remoteIP() != connection.ip) {
+        connection.ip = client.remoteIP();
+        connection.port = client.remotePort();
+        connection.requests = 0;
+    }
+    // the last response of a connection is sent with "Connection: close"
+    server->keepAlive(++connection.requests < WEB_KEEP_ALIVE_MAX_REQUESTS);
+
+    metrics.beginRequest(route);
+    {
+        // everything the handler took from the arena is released after its response
+        RequestArena::Scope arenaScope;
+        handler();
+    }
+    metrics.endRequest();
+    connection.lastRequestMs = millis();
+}
+
+/**
+ * Register a web server handler, every request of the route is measured in the metrics
+ */
+void onRoute(const char* uri, HTTPMethod method, void (*handler)())
+{
+    auto &server = p_var->server;
+    auto &metrics = p_var->metrics;
+    int route = metrics.addRoute(uri, method == HTTP_POST ? "POST" : "GET");
+    server->on(uri, method, [route, handler]() {
+        serveRoute(route, handler);
+    });
+}
+
+/**
+ * POST route that reads its body through the raw body hook of the server:
+ * the body is streamed into the request body buffer in chunks instead of
+ * being collected in the "plain" argument, what doesn't fit is dropped
+ * chunk by chunk, so a large body never reaches the heap (see parseBody())
+ */
+class BodyRequestHandler : public esp8266webserver::RequestHandler<BearSSL::WiFiServerSecure> {
+public:
+    BodyRequestHandler(const char* uri, int route, void (*handler)())
+        : m_uri(uri)
+        , m_route(route)
+        , m_handler(handler)
+    {
+    }
+
+    bool canHandle(HTTPMethod method, const String& uri) override
+    {
+        return method == HTTP_POST && uri == m_uri;
+    }
+
+    bool canRaw(const String& uri) override
+    {
+        return uri == m_uri;
+    }
+
+    void raw(BearSSL::ESP8266WebServerSecure&, const String&, HTTPRaw& raw) override
+    {
+        auto &body = p_var->requestBody;
+        if (raw.status == RAW_START) {
+            body.begin();
+        } else if (raw.status == RAW_WRITE) {
+            body.write(raw.buf, raw.currentSize);
+        }
+    }
+
+    bool handle(BearSSL::ESP8266WebServerSecure&, HTTPMethod, const String&) override
+    {
+        serveRoute(m_route, m_handler);
+        p_var->requestBody.begin(); // a request without body doesn't start a raw body
+        return true;
+    }
+
+private:
+    const char* m_uri;
+    int m_route;
+    void (*m_handler)();
+};
+
+void onBodyRoute(const char* uri, void (*handler)())
+{
+    auto &server = p_var->server;
+    auto &metrics = p_var->metrics;
+    int route = metrics.addRoute(uri, "POST");
+    server->addHandler(new BodyRequestHandler(uri, route, handler));
+}
+
+void sendResponse(int code, const char* contentType, const String& content)
+{
+    auto &server = p_var->server;
+    auto &metrics = p_var->metrics;
+    metrics.setStatus(code);
+    server->send(code, contentType, content);
+}
+
+void requestAuthentication()
+{
+    auto &server = p_var->server;
+    auto &metrics = p_var->metrics;
+    metrics.setStatus(401);
+    server->requestAuthentication();
+}
+
+/**
+ * Content negotiation, CBOR if the client asks for it, json otherwise
+ */
+bool acceptsCbor()
+{
+    auto &server = p_var->server;
+    return server->header("Accept").indexOf(CBOR_CONTENT_TYPE) >= 0;
+}
+
+/**
+ * Parse the body of an onBodyRoute() request in place, CBOR or json depending
+ * on its Content-Type, root is only valid until the next request
+ *
+ * @return false if the body is too large, the 413 is already sent
+ */
+template <class JsonBuffer>
+bool parseBody(JsonBuffer& jsonBuffer, JsonVariant& root)
+{
+    auto &logger = p_var->logger;
+    auto &server = p_var->server;
+    auto &body = p_var->requestBody;
+    if (body.isOverflow()) {
+        LOGGER_WARN(logger, "[Webserver] request body larger than " + String(WEB_MAX_BODY_SIZE) + " bytes");
+        sendResponse(413, "text/html", "request body too large");
+        return false;
+    }
+    if (server->header("Content-Type").startsWith(CBOR_CONTENT_TYPE)) {
+        root = body.parseCbor(jsonBuffer);
+    } else {
+        root = body.parseJson(jsonBuffer);
+    }
+    return true;
+}
+
+/**
+ * Stream a 200 response in the negotiated encoding,
+ * body(writer) gets a JsonWriter or a CborWriter
+ *
+ * @return peak heap usage of the response
+ */
+template <typename Body>
+uint32_t sendStructured(Body body)
+{
+    auto &server = p_var->server;
+    server->sendHeader("Vary", "Accept");
+    WebResponse response(*server);
+    if (acceptsCbor()) {
+        response.begin(200, CBOR_CONTENT_TYPE);
+        CborWriter cbor(response);
+        body(cbor);
+    } else {
+        response.begin(200, "application/json");
+        JsonWriter json(response);
+        body(json);
+    }
+    response.end();
+    return response.heapUsage();
+}
+
 void setupWebServer()
 {
     auto &logger = p_var->logger;
     auto &server = p_var->server;
-    logger.log("[Setup Webserver]");
+    auto &tlsSessions = p_var->tlsSessions;
+    LOGGER_INFO(logger, "[Setup Webserver]");
     server.reset(new BearSSL::ESP8266WebServerSecure(443));
+    server->keepAlive(true);
+    // request headers read by the handlers, the server drops all others
+    static const char* headerKeys[] = { "If-None-Match", "Accept", "Content-Type" };
+    server->collectHeaders(headerKeys, sizeof(headerKeys) / sizeof(headerKeys[0]));
     // server->getServer().setRSACert(new BearSSL::X509List(ssl::serverCert), new BearSSL::PrivateKey(ssl::serverKey));
     server->getServer().setECCert(new BearSSL::X509List(ssl::serverCert), BR_KEYTYPE_EC, new BearSSL::PrivateKey(ssl::serverKey));
 
-    server->on("/", HTTP_GET, []() {
+    // the session cache outlives the server, so clients can keep resuming after a webserver reset
+    // a resumed handshake skips the ECDHE and ECDSA operations, which take the bulk of the handshake time
+    if (!tlsSessions) {
+        tlsSessions.reset(new BearSSL::ServerSessions(TLS_SESSION_CACHE_SIZE));
+    }
+    server->getServer().setCache(tlsSessions.get());
+
+    onRoute("/", HTTP_GET, []() {
         auto &logger = p_var->logger;
-        auto &server = p_var->server;
-        logger.log("[Webserver] serve /");
+        LOGGER_INFO(logger, "[Webserver] serve /");
         String response =
             "<!DOCTYPE html>"
             "<html>"
@@ -318,107 +768,87 @@ void setupWebServer()
             "</ul>"
             "</body>"
             "</html>";
-        server->send(200, "text/html", response);
+        sendResponse(200, "text/html", response);
     });
 
-    server->on("/api/version", HTTP_GET, []() {
+    onRoute("/api/version", HTTP_GET, []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
         auto &config = p_var->config;
-        logger.log("[Webserver] serve /api/version");
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& rootObject = jsonBuffer.createObject();
-
-        JsonObject& jsonObjectApi = rootObject.createNestedObject("api");
-        jsonObjectApi.set("version", config.getConfigVersion());
-
-        JsonObject& jsonObjectVersion = rootObject.createNestedObject("software");
-        jsonObjectVersion.set(F("version"), version::VERSION_STRING);
-        jsonObjectVersion.set(F("git_tag"), version::GIT_TAG_NAME);
-        jsonObjectVersion.set(F("git_commits_since_tag"), version::GIT_COMMITS_SINCE_TAG);
-        jsonObjectVersion.set(F("git_commit_id"), version::GIT_COMMIT_ID);
-        jsonObjectVersion.set(F("modified_since_commit"), version::MODIFIED_SINCE_COMMIT);
-        jsonObjectVersion.set(F("is_dev_version"), version::IS_DEV_VERSION);
-        jsonObjectVersion.set(F("is_stable_version"), version::IS_STABLE_VERSION);
-        jsonObjectVersion.set(F("build_date"), __DATE__);
-        jsonObjectVersion.set(F("build_time"), __TIME__);
-
-        String response;
-        rootObject.prettyPrintTo(response);
-        server->send(200, "application/json", response);
+        LOGGER_INFO(logger, "[Webserver] serve /api/version");
+        WebResponse response(*server);
+        response.begin(200, "application/json");
+        JsonWriter json(response);
+        json.beginObject();
+
+        json.beginObject(F("api"));
+        json.set(F("version"), config.getConfigVersion());
+        json.endObject();
+
+        json.beginObject(F("software"));
+        json.set(F("version"), version::VERSION_STRING);
+        json.set(F("git_tag"), version::GIT_TAG_NAME);
+        json.set(F("git_commits_since_tag"), version::GIT_COMMITS_SINCE_TAG);
+        json.set(F("git_commit_id"), version::GIT_COMMIT_ID);
+        json.set(F("modified_since_commit"), version::MODIFIED_SINCE_COMMIT);
+        json.set(F("is_dev_version"), version::IS_DEV_VERSION);
+        json.set(F("is_stable_version"), version::IS_STABLE_VERSION);
+        json.set(F("build_date"), __DATE__);
+        json.set(F("build_time"), __TIME__);
+        json.endObject();
+
+        json.endObject();
+        response.end();
+        LOGGER_DEBUG(logger, "[Webserver] /api/version peak heap: " + String(response.heapUsage()));
     });
 
-    server->on("/api/reboot", HTTP_GET, []() {
+    onRoute("/api/reboot", HTTP_GET, []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
         if (!server->authenticate(WWW_USER, WWW_PASS)) {
-            return server->requestAuthentication();
+            return requestAuthentication();
         }
-        logger.log("[Webserver] serve /api/reboot");
-        server->send(200, "text/html", "ok");
+        LOGGER_INFO(logger, "[Webserver] serve /api/reboot");
+        sendResponse(200, "text/html", "ok");
         server->client().flush();
         resetDnsServer();
         resetWebServer();
-        digitalWrite(pins_arr, LOW); // prevent to fast flicker by early power-off
+        Storage::flush();
+        logger.flushQueue();
+        digitalWrite(board::relays, &RelayConfig::offLevel); // prevent to fast flicker by early power-off
         delay(2000);
         ESP.restart();
     });
 
-    server->on("/api/systeminfo", HTTP_GET, []() {
+    // ?fields=free_heap,rssi or ?fields=dynamic, only the requested fields
+    onRoute("/api/systeminfo", HTTP_GET, []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
-        auto &bootTimeStorage = p_var->bootTimeStorage;
-        logger.log("[Webserver] serve /api/systeminfo");
-        DynamicJsonBuffer jsonBuffer;
-        int bootCount = bootTimeStorage.loadJson(jsonBuffer)["bootcount"];
-
-        JsonObject& rootObject = jsonBuffer.createObject();
-        rootObject.set(F("chip_id"), ESP.getChipId());
-        rootObject.set(F("power_voltage"), (float)ESP.getVcc() / 1024.00f);
-        rootObject.set(F("boot_mode"), ESP.getBootMode());
-        rootObject.set(F("boot_version"), ESP.getBootVersion());
-        rootObject.set(F("boot_count"), bootCount);
-        rootObject.set(F("core_version"), ESP.getCoreVersion());
-        rootObject.set(F("cpu_freq_mhz"), ESP.getCpuFreqMHz());
-        rootObject.set(F("cycle_count"), ESP.getCycleCount());
-        rootObject.set(F("flash_chip_id"), ESP.getFlashChipId());
-        rootObject.set(F("flash_chip_mode"), ESP.getFlashChipMode());
-        rootObject.set(F("flash_chip_real_size"), ESP.getFlashChipRealSize());
-        rootObject.set(F("flash_chip_size"), ESP.getFlashChipSize());
-        rootObject.set(F("flash_chip_size_by_chip_id"), ESP.getFlashChipSizeByChipId());
-        rootObject.set(F("flash_chip_speed"), ESP.getFlashChipSpeed());
-        rootObject.set(F("free_heap"), ESP.getFreeHeap());
-        rootObject.set(F("free_sketch_space"), ESP.getFreeSketchSpace());
-        rootObject.set(F("reset_info"), ESP.getResetInfo());
-        rootObject.set(F("reset_info_depc"), ESP.getResetInfoPtr()->depc);
-        rootObject.set(F("reset_info_epc1"), ESP.getResetInfoPtr()->epc1);
-        rootObject.set(F("reset_info_epc2"), ESP.getResetInfoPtr()->epc2);
-        rootObject.set(F("reset_info_epc3"), ESP.getResetInfoPtr()->epc3);
-        rootObject.set(F("reset_info_exccause"), ESP.getResetInfoPtr()->exccause);
-        rootObject.set(F("reset_info_excvaddr"), ESP.getResetInfoPtr()->excvaddr);
-        rootObject.set(F("reset_info_reason"), ESP.getResetInfoPtr()->reason);
-        rootObject.set(F("reset_reason"), ESP.getResetReason());
-        rootObject.set(F("sdk_version"), ESP.getSdkVersion());
-        rootObject.set(F("sketch_md5"), ESP.getSketchMD5());
-        rootObject.set(F("sketch_size"), ESP.getSketchSize());
-        rootObject.set(F("loop_freq_mhz"), loopFrequency);
-        rootObject.set(F("ip_address"), WiFi.localIP().toString());
-        rootObject.set(F("device_id"), deviceId);
-        String response;
-        rootObject.prettyPrintTo(response);
-        server->send(200, "application/json", response);
+        LOGGER_INFO(logger, "[Webserver] serve /api/systeminfo");
+        SystemInfo::Runtime runtime;
+        runtime.loopFrequency = loopFrequency;
+        runtime.logDropped = logger.getDroppedCount();
+        runtime.logQueueHighWater = logger.getQueueHighWater();
+        runtime.ipAddress = WiFi.localIP().toString();
+        runtime.rssi = WiFi.RSSI();
+
+        String fields = server->arg("fields");
+        uint32_t heapUsage = sendStructured([&](auto& writer) {
+            p_var->systemInfo.printTo(writer, runtime, fields.c_str());
+        });
+        LOGGER_DEBUG(logger, "[Webserver] /api/systeminfo peak heap: " + String(heapUsage));
     });
 
-    server->on("/api/config/reset", HTTP_GET, []() {
+    onRoute("/api/config/reset", HTTP_GET, []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
         auto &config = p_var->config;
         auto &bootTimeStorage = p_var->bootTimeStorage;
         if (!server->authenticate(WWW_USER, WWW_PASS)) {
-            return server->requestAuthentication();
+            return requestAuthentication();
         }
-        logger.log("[Webserver] serve /api/config/reset");
-        server->send(200, "text/html", "ok");
+        LOGGER_INFO(logger, "[Webserver] serve /api/config/reset");
+        sendResponse(200, "text/html", "ok");
         server->client().flush();
         config.reset();
         WiFi.disconnect(true);
@@ -426,198 +856,450 @@ void setupWebServer()
         resetWebServer();
         bootTimeStorage.reset();
         showConfig();
+        Storage::flush();
+        logger.flushQueue();
         ESP.reset();
     });
 
-    server->on("/api/config/reload", HTTP_GET, []() {
+    onRoute("/api/config/reload", HTTP_GET, []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
+        auto &config = p_var->config;
         if (!server->authenticate(WWW_USER, WWW_PASS)) {
-            return server->requestAuthentication();
+            return requestAuthentication();
         }
-        logger.log("[Webserver] serve /api/config/reload");
-        server->send(200, "text/html", "ok");
+        LOGGER_INFO(logger, "[Webserver] serve /api/config/reload");
+        config.reload();
+        sendResponse(200, "text/html", "ok");
         tryWiFiReconnect = true;
     });
 
-    server->on("/api/config", HTTP_POST, []() {
+    onBodyRoute("/api/config", []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
         auto &config = p_var->config;
         if (!server->authenticate(WWW_USER, WWW_PASS)) {
-            return server->requestAuthentication();
+            return requestAuthentication();
         }
-        logger.log("[Webserver] serve /api/config");
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& rootObject = jsonBuffer.parseObject(server->arg("plain"));
+        LOGGER_INFO(logger, "[Webserver] serve /api/config");
+        StaticJsonBuffer<CONFIG_JSON_BUFFER_SIZE> jsonBuffer;
+        JsonVariant root;
+        if (!parseBody(jsonBuffer, root)) {
+            return;
+        }
+        JsonObject& rootObject = root.as<JsonObject>();
         if (!rootObject.success()) {
-            server->send(400, "text/html", "invalid json object");
+            sendResponse(400, "text/html", "invalid json object");
             return;
         }
 
-        bool success = false;
+        Config::Transaction transaction = config.begin();
+        bool found = false;
         if (rootObject.containsKey("wifi")) {
             JsonObject& jsonobjectWifi = rootObject.get<JsonVariant>("wifi").as<JsonObject>();
             String ssid = jsonobjectWifi["ssid"] | "";
             String pass = jsonobjectWifi["pass"] | "";
-            config.setWifiConfig(ssid, pass);
-            success = true;
+            transaction.setWifi(ssid, pass);
+            found = true;
         }
 
         if (rootObject.containsKey("syslog")) {
             JsonObject& jsonobjectSyslog = rootObject.get<JsonVariant>("syslog").as<JsonObject>();
             String ip = jsonobjectSyslog["ip"] | "";
             int port = jsonobjectSyslog["port"] | 514;
-            config.setSyslogConfig(ip, port);
-            success = true;
+            transaction.setSyslog(ip, port);
+            found = true;
         }
 
-        if (success) {
-            showConfig();
-            server->send(200, "text/html", "ok");
-        } else {
-            server->send(400, "text/html", "no valid config found");
+        if (rootObject.containsKey("mqtt")) {
+            JsonObject& jsonobjectMqtt = rootObject.get<JsonVariant>("mqtt").as<JsonObject>();
+            String ip = jsonobjectMqtt["ip"] | "";
+            int port = jsonobjectMqtt["port"] | 1883;
+            transaction.setMqtt(ip, port);
+            found = true;
+        }
+
+        if (!found) {
+            sendResponse(400, "text/html", "no valid config found");
+            return;
+        }
+
+        uint8_t changed;
+        if (!transaction.commit(&changed)) {
+            LOGGER_WARN(logger, "[Webserver] /api/config rejected: " + String(transaction.getError()));
+            sendResponse(400, "text/html", transaction.getError());
+            return;
+        }
+
+        showConfig();
+        sendResponse(200, "text/html", "ok");
+
+        // only restart what changed, mqtt follows the config by itself
+        if (changed & Config::SECTION_SYSLOG) {
+            setupSyslog();
+        }
+        if (changed & Config::SECTION_WIFI) {
+            if (WiFi.getMode() & WIFI_AP) {
+                tryWiFiReconnect = true; // config portal, setupWiFi() takes over
+            } else {
+                wifiConfigChangedMs = millis();
+                setLoopListCb(applyWiFiConfig, "wifi-config", 0, Scheduler::PRIORITY_LOW, []() {
+                    return millis() - wifiConfigChangedMs > WIFI_CONFIG_APPLY_DELAY_MS;
+                });
+            }
         }
     });
 
-    server->on("/api/config", HTTP_GET, []() {
+    onRoute("/api/config", HTTP_GET, []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
         auto &config = p_var->config;
         if (!server->authenticate(WWW_USER, WWW_PASS)) {
-            return server->requestAuthentication();
+            return requestAuthentication();
         }
-        logger.log("[Webserver] serve /api/config");
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& rootObject = jsonBuffer.createObject();
-
-        rootObject.set("version", config.getConfigVersion());
+        LOGGER_INFO(logger, "[Webserver] serve /api/config");
+        const Config::Data& data = config.getData();
+        char wifi_mask[65]; // the pass is at most 64 characters (Config::Transaction::setWifi)
+        size_t passLength = data.wifi.pass.length() ? min((size_t)data.wifi.pass.length(), sizeof(wifi_mask) - 1) : 1;
+        memset(wifi_mask, '*', passLength);
+        wifi_mask[0] = data.wifi.pass.length() ? data.wifi.pass[0] : '*';
+        wifi_mask[passLength] = '\0';
+
+        uint32_t heapUsage = sendStructured([&](auto& json) {
+            json.beginObject();
+            json.set(F("version"), data.version);
+
+            json.beginObject(F("wifi"));
+            json.set(F("ssid"), data.wifi.ssid);
+            json.set(F("pass"), wifi_mask);
+            json.endObject();
+
+            json.beginObject(F("syslog"));
+            json.set(F("ip"), data.syslog.ip);
+            json.set(F("port"), data.syslog.port);
+            json.endObject();
+
+            json.beginObject(F("mqtt"));
+            json.set(F("ip"), data.mqtt.ip);
+            json.set(F("port"), data.mqtt.port);
+            json.endObject();
+
+            json.endObject();
+        });
+        LOGGER_DEBUG(logger, "[Webserver] /api/config peak heap: " + String(heapUsage));
+    });
 
-        String wifi_ssid, wifi_pass;
-        config.getWifiConfig(wifi_ssid, wifi_pass);
-        String wifi_mask = String(wifi_pass.length() ? wifi_pass[0] : '*');
-        for (size_t i = 1; i < wifi_pass.length(); i++) {
-            wifi_mask += '*';
+    onBodyRoute("/api/set", []() {
+        auto &logger = p_var->logger;
+        auto &server = p_var->server;
+        if (!server->authenticate(WWW_USER, WWW_PASS)) {
+            return requestAuthentication();
+        }
+        LOGGER_INFO(logger, "[Webserver] serve /api/set");
+        StaticJsonBuffer<SET_JSON_BUFFER_SIZE> jsonBuffer;
+        JsonVariant root;
+        if (!parseBody(jsonBuffer, root)) {
+            return;
         }
-        JsonObject& jsonobjectWifi = rootObject.createNestedObject("wifi");
-        jsonobjectWifi.set("ssid", wifi_ssid);
-        jsonobjectWifi.set("pass", wifi_mask);
 
-        String syslog_server;
-        int syslog_port;
-        config.getSyslogConfig(syslog_server, syslog_port);
-        JsonObject& jsonobjectSyslog = rootObject.createNestedObject("syslog");
-        jsonobjectSyslog.set("ip", syslog_server);
-        jsonobjectSyslog.set("port", syslog_port);
+        if (root.is<JsonArray>()) {
+            if (!setPins(root.as<JsonArray>())) {
+                sendResponse(400, "text/html", "no valid json set array");
+                return;
+            }
 
-        String response;
-        rootObject.prettyPrintTo(response);
-        server->send(200, "application/json", response);
+            // report the resulting state of every relay
+            sendStructured([](auto& json) {
+                json.beginArray();
+                for (uint8_t i = 0; i < board::RELAY_COUNT; i++) {
+                    json.beginObject();
+                    json.set(F("relay"), i + 1);
+                    json.set(F("value"), board::isOn(board::relays[i]));
+                    json.endObject();
+                }
+                json.endArray();
+            });
+        } else if (setPin(root.as<JsonObject>())) {
+            sendResponse(200, "text/html", "ok");
+        } else {
+            sendResponse(400, "text/html", "no valid json set object");
+        }
     });
 
-    server->on("/api/set", HTTP_POST, []() {
+    onRoute("/api/events", HTTP_GET, []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
-        if (!server->authenticate(WWW_USER, WWW_PASS)) {
-            return server->requestAuthentication();
+        auto &metrics = p_var->metrics;
+        auto &events = p_var->events;
+        auto &connection = p_var->webConnection;
+        LOGGER_INFO(logger, "[Webserver] serve /api/events");
+        uint8_t topics = WebEvents::TOPIC_RELAY;
+        if (server->arg("metrics") == "1") {
+            topics |= WebEvents::TOPIC_METRICS;
         }
-        logger.log("[Webserver] serve /api/set");
-        DynamicJsonBuffer jsonBuffer;
-        JsonObject& rootObject = jsonBuffer.parseObject(server->arg("plain"));
 
-        if (setPin(rootObject)) {
-            server->send(200, "text/html", "ok");
-        } else {
-            server->send(400, "text/html", "no valid json set object");
+        int id = events.subscribe(server->client(), topics);
+        if (id < 0) {
+            sendResponse(503, "text/html", "too many subscribers");
+            return;
+        }
+        metrics.setStatus(200);
+
+        // the connection belongs to the event stream now, the webserver only drops its reference
+        server->keepAlive(false);
+        connection.port = 0;
+        connection.requests = 0;
+
+        // start with the complete state
+        for (uint8_t i = 0; i < board::RELAY_COUNT; i++) {
+            char data[32];
+            formatRelayEvent(data, sizeof(data), i);
+            events.publishTo(id, "relay", data);
         }
     });
 
-    server->on("/api/get", HTTP_GET, []() {
+    onRoute("/api/get", HTTP_GET, []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
-        logger.log("[Webserver] serve /api/get");
-        DynamicJsonBuffer jsonBuffer;
+        LOGGER_INFO(logger, "[Webserver] serve /api/get");
+        ArenaJsonBuffer jsonBuffer;
         // JsonObject& rootObject = jsonBuffer.parseObject(server->arg("plain"));
         JsonObject& rootObject = jsonBuffer.createObject();
         rootObject.set("relay", server->arg("relay").toInt());
 
         if (getPin(rootObject)) {
-            String response;
-            rootObject.prettyPrintTo(response);
-            server->send(200, "application/json", response);
+            sendStructured([&](auto& json) {
+                json.beginObject();
+                json.set(F("relay"), rootObject["relay"].as<int>());
+                json.set(F("value"), rootObject["value"].as<bool>());
+                json.endObject();
+            });
         } else {
-            server->send(400, "text/html", "no valid get request");
+            sendResponse(400, "text/html", "no valid get request");
+        }
+    });
+
+    // everything a controller polls in one compact response, the ETag only changes with the
+    // relay state (or a reboot), so an unchanged state is answered with an empty 304
+    onRoute("/api/state", HTTP_GET, []() {
+        auto &logger = p_var->logger;
+        auto &server = p_var->server;
+        LOGGER_DEBUG(logger, "[Webserver] serve /api/state"); // polled, keep it out of the INFO log
+
+        char etag[24];
+        snprintf(etag, sizeof(etag), "\"%d-%lu\"", bootCount, (unsigned long)stateGeneration);
+        server->sendHeader("ETag", etag);
+        server->sendHeader("Cache-Control", "no-cache");
+        if (server->header("If-None-Match").indexOf(etag) >= 0) {
+            return sendResponse(304, "application/json", "");
+        }
+
+        WebResponse response(*server);
+        response.begin(200, "application/json");
+        JsonWriter json(response);
+        json.beginObject();
+        json.set(F("generation"), stateGeneration);
+        json.beginArray(F("relays"));
+        for (uint8_t i = 0; i < board::RELAY_COUNT; i++) {
+            json.add(board::isOn(board::relays[i]));
         }
+        json.endArray();
+        json.set(F("version"), version::VERSION_STRING);
+        json.beginObject(F("health"));
+        json.set(F("uptime"), millis() / 1000);
+        json.set(F("boot_count"), bootCount);
+        json.set(F("free_heap"), ESP.getFreeHeap());
+        json.set(F("max_free_block_size"), ESP.getMaxFreeBlockSize());
+        json.set(F("rssi"), WiFi.RSSI());
+        json.endObject();
+        json.endObject();
+        response.end();
     });
 
-    server->on("/api/ota", HTTP_GET, []() {
+    onRoute("/api/ota", HTTP_GET, []() {
         auto &logger = p_var->logger;
         auto &server = p_var->server;
         auto &otaLogStorage = p_var->otaLogStorage;
-        logger.log("[Webserver] serve /api/ota");
-        DynamicJsonBuffer jsonBuffer;
+        LOGGER_INFO(logger, "[Webserver] serve /api/ota");
+        ArenaJsonBuffer jsonBuffer;
         JsonObject& rootObject = otaLogStorage.loadJson(jsonBuffer);
         otaLogStorage.reset();
-        String response;
-        rootObject.prettyPrintTo(response);
-        server->send(200, "application/json", response);
+        WebResponse response(*server);
+        response.begin(200, "application/json");
+        rootObject.printTo(response);
+        response.end();
+    });
+
+    onRoute("/api/metrics", HTTP_GET, []() {
+        auto &logger = p_var->logger;
+        auto &server = p_var->server;
+        auto &metrics = p_var->metrics;
+        LOGGER_DEBUG(logger, "[Webserver] serve /api/metrics");
+        WebResponse response(*server);
+        response.begin(200, "text/plain; version=0.0.4");
+        Metrics::printGauge(response, F("smarthue_free_heap_bytes"), F("Free heap."), ESP.getFreeHeap());
+        Metrics::printGauge(response, F("smarthue_max_free_block_bytes"), F("Largest allocatable heap block."), ESP.getMaxFreeBlockSize());
+        Metrics::printGauge(response, F("smarthue_heap_fragmentation_percent"), F("Heap fragmentation."), ESP.getHeapFragmentation());
+        Metrics::printGauge(response, F("smarthue_wifi_rssi_dbm"), F("WiFi signal strength."), WiFi.RSSI());
+        Metrics::printGauge(response, F("smarthue_uptime_seconds"), F("Time since boot."), millis() / 1000);
+        Metrics::printGauge(response, F("smarthue_boot_count"), F("Amount of boots."), bootCount);
+        Metrics::printCounter(response, F("smarthue_log_dropped_total"), F("Log lines dropped by a full log queue."), logger.getDroppedCount());
+        Metrics::printGauge(response, F("smarthue_event_subscribers"), F("Open /api/events streams."), p_var->events.size());
+        Metrics::printCounter(response, F("smarthue_event_subscribers_dropped_total"), F("Event streams closed because the client could not keep up."), p_var->events.getDropped());
+        Metrics::printCounter(response, F("smarthue_storage_flush_failures_total"), F("Failed writes of the deferred storage documents to flash."), Storage::getFlushFailures());
+        Metrics::printGauge(response, F("smarthue_request_arena_high_water_bytes"), F("Most of the request arena ever in use."), RequestArena::instance().getHighWater());
+        Metrics::printCounter(response, F("smarthue_request_arena_fallbacks_total"), F("Allocations that did not fit in the request arena and went to the heap."), RequestArena::instance().getFallbacks());
+        metrics.printTo(response, board::RELAY_COUNT);
+        response.end();
+    });
+
+    onRoute("/api/profile", HTTP_GET, []() {
+        auto &logger = p_var->logger;
+        auto &server = p_var->server;
+        auto &scheduler = p_var->scheduler;
+        if (!server->authenticate(WWW_USER, WWW_PASS)) {
+            return requestAuthentication();
+        }
+        LOGGER_INFO(logger, "[Webserver] serve /api/profile");
+        WebResponse response(*server);
+        response.begin(200, "application/json");
+        JsonWriter json(response);
+        json.beginObject();
+        json.set(F("cpu_freq_mhz"), ESP.getCpuFreqMHz());
+
+        json.beginArray(F("histogram_cycles"));
+        for (size_t bucket = 0; bucket < SCHEDULER_HISTOGRAM_BUCKETS; bucket++) {
+            json.add(Scheduler::bucketCycles(bucket));
+        }
+        json.endArray();
+
+        json.beginArray(F("tasks"));
+        for (size_t i = 0; i < scheduler.size(); i++) {
+            const Scheduler::Task& task = scheduler.get(i);
+            json.beginObject();
+            json.set(F("name"), task.name ? task.name : "");
+            json.set(F("priority"), task.priority);
+            json.set(F("period_ms"), task.periodMs);
+            json.set(F("budget_us"), task.budgetUs);
+            json.set(F("overruns"), task.overruns);
+            json.set(F("calls"), task.profile.calls);
+            json.set(F("total_cycles"), task.profile.totalCycles);
+            json.set(F("max_cycles"), task.profile.maxCycles);
+            json.beginArray(F("histogram"));
+            for (size_t bucket = 0; bucket < SCHEDULER_HISTOGRAM_BUCKETS; bucket++) {
+                json.add(task.profile.histogram[bucket]);
+            }
+            json.endArray();
+            json.endObject();
+        }
+        json.endArray();
+
+        json.endObject();
+        response.end();
+    });
+
+    onRoute("/api/profile/reset", HTTP_GET, []() {
+        auto &logger = p_var->logger;
+        auto &server = p_var->server;
+        auto &scheduler = p_var->scheduler;
+        if (!server->authenticate(WWW_USER, WWW_PASS)) {
+            return requestAuthentication();
+        }
+        LOGGER_INFO(logger, "[Webserver] serve /api/profile/reset");
+        scheduler.resetProfile();
+        sendResponse(200, "text/html", "ok");
     });
 
     server->begin();
-    setLoopListCb(serveWebServer);
+    setLoopListCb(serveWebServer, "webserver", 0, Scheduler::PRIORITY_HIGH, nullptr, WEB_SERVER_BUDGET_US);
+    setLoopListCb(serveEvents, "events", 0, Scheduler::PRIORITY_NORMAL, []() {
+        return p_var->events.size() > 0;
+    });
 }
 
 void resetWebServer()
 {
     auto &logger = p_var->logger;
     auto &server = p_var->server;
-    logger.log("[Reset Webserver]");
+    LOGGER_INFO(logger, "[Reset Webserver]");
+    p_var->events.clear();
     server.reset();
     removeLoopListCb(serveWebServer);
+    removeLoopListCb(serveEvents);
 }
 
 void serveWebServer()
 {
     auto &server = p_var->server;
+    auto &connection = p_var->webConnection;
     server->handleClient();
-    server->client().flush();
+
+    // close a kept alive connection that stays idle for too long
+    WiFiClient &client = server->client();
+    if (connection.requests && client.connected() && client.remotePort() == connection.port
+        && client.remoteIP() == connection.ip && millis() - connection.lastRequestMs > WEB_KEEP_ALIVE_IDLE_MS) {
+        client.stop();
+        connection.requests = 0;
+    }
+}
+
+void serveEvents()
+{
+    auto &events = p_var->events;
+    static unsigned long heartbeatMs = 0;
+    static unsigned long metricsMs = 0;
+
+    unsigned long timeNow = millis();
+    if (timeNow - heartbeatMs >= EVENTS_HEARTBEAT_MS) {
+        heartbeatMs = timeNow;
+        events.heartbeat();
+    }
+    if (timeNow - metricsMs >= EVENTS_METRICS_MS) {
+        metricsMs = timeNow;
+        char data[96];
+        snprintf(data, sizeof(data), "{\"uptime\":%lu,\"free_heap\":%u,\"loop_frequency\":%.1f,\"rssi\":%d}",
+            timeNow / 1000, ESP.getFreeHeap(), loopFrequency, WiFi.RSSI());
+        events.publish(WebEvents::TOPIC_METRICS, "metrics", data);
+    }
+
+    events.serve();
 }
 
 void setupConfigAp()
 {
     auto &logger = p_var->logger;
-    logger.log(F("[Setup config AP]"));
+    LOGGER_INFO(logger, F("[Setup config AP]"));
     delay(100);
     WiFi.persistent(false);
     WiFi.disconnect();
     WiFi.softAPdisconnect();
     WiFi.mode(WIFI_AP);
 
-    logger.log(F("[Setup config AP] configuring access point... "));
+    LOGGER_INFO(logger, F("[Setup config AP] configuring access point... "));
     WiFi.softAPConfig(LOCAL_IP, GATEWAY_IP, SUBNET_IP); 
     WiFi.softAP(WIFI_AP_SSID, WIFI_AP_PASS, WIFI_AP_CHANNEL, WIFI_AP_HIDDEN);
     WiFi.onSoftAPModeProbeRequestReceived([](const WiFiEventSoftAPModeProbeRequestReceived &dst) {
         auto &logger = p_var->logger;
-        logger.log("[Connect config AP] mac = " + macToString(dst.mac) + ", rssi = " + dst.rssi + ": probe request received");
+        LOGGER_INFO(logger, "[Connect config AP] mac = " + macToString(dst.mac) + ", rssi = " + dst.rssi + ": probe request received");
     });
     WiFi.onSoftAPModeStationConnected([](const WiFiEventSoftAPModeStationConnected &dst) {
         auto &logger = p_var->logger;
-        logger.log("[Connect config AP] mac = " + macToString(dst.mac) + ", aid = " + dst.aid + ": station connected");
+        LOGGER_INFO(logger, "[Connect config AP] mac = " + macToString(dst.mac) + ", aid = " + dst.aid + ": station connected");
     });
     WiFi.onSoftAPModeStationDisconnected([](const WiFiEventSoftAPModeStationDisconnected &dst) {
         auto &logger = p_var->logger;
-        logger.log("[Connect config AP] mac = " + macToString(dst.mac) + ", aid = " + dst.aid + ": station disconnected");
+        LOGGER_INFO(logger, "[Connect config AP] mac = " + macToString(dst.mac) + ", aid = " + dst.aid + ": station disconnected");
     });
     WiFi.begin();
 
     delay(500);
-    logger.log("[Config config AP] IP address: " + WiFi.softAPIP().toString());
+    LOGGER_INFO(logger, "[Config config AP] IP address: " + WiFi.softAPIP().toString());
 }
 
 void resetConfigAp()
 {
     auto &logger = p_var->logger;
-    logger.log(F("[Reset config AP] reset config AP"));
+    LOGGER_INFO(logger, F("[Reset config AP] reset config AP"));
     WiFi.disconnect();
     WiFi.softAPdisconnect();
     WiFi.mode(WIFI_STA);
@@ -628,16 +1310,16 @@ bool beginWiFi()
 {
     auto &logger = p_var->logger;
     auto &config = p_var->config;
-    logger.log(F("[WiFi] begin WiFi connection..."), Logger::DEBUG);
+    LOGGER_DEBUG(logger, F("[WiFi] begin WiFi connection..."));
 
     String ssid, pass;
     config.getWifiConfig(ssid, pass);
     if (ssid.isEmpty()) {
-        logger.log(F("[WiFi] no SSID configured yet, skipping connection"), Logger::WARN);
+        LOGGER_WARN(logger, F("[WiFi] no SSID configured yet, skipping connection"));
         return false;
     }
 
-    logger.log(F("[WiFi] SSID found, begin connection attempt"), Logger::DEBUG);
+    LOGGER_DEBUG(logger, F("[WiFi] SSID found, begin connection attempt"));
     WiFi.persistent(false); // 2.2.0 Exception (3): #1997
     WiFi.disconnect(true);
     // Begin wifi after disconnecting, to solve a weird bug reported at
@@ -647,21 +1329,33 @@ bool beginWiFi()
     return true; 
 }
 
+/**
+ * One-shot loop task: reconnect with the new wifi config.
+ */
+void applyWiFiConfig()
+{
+    auto &logger = p_var->logger;
+    removeLoopListCb(applyWiFiConfig);
+    LOGGER_INFO(logger, F("[WiFi] config changed, reconnect"));
+    beginWiFi();
+}
+
 bool reconnectWiFi(bool force)
 {
     auto &logger = p_var->logger;
     if (WiFi.isConnected()) {
-        logger.log("[WIFI] connected, IP address: " + WiFi.localIP().toString());
+        LOGGER_INFO(logger, "[WIFI] connected, IP address: " + WiFi.localIP().toString());
         return true;
     } 
 
-    logger.log(F("[WiFi] attempting WiFi connection..."), Logger::DEBUG);
+    LOGGER_DEBUG(logger, F("[WiFi] attempting WiFi connection..."));
     if (force) {
+        p_var->metrics.countWifiReconnect();
         WiFi.reconnect();
     }
 
     if (doWhileLoopDelay(10000, []() { return WiFi.isConnected(); })) {
-        logger.log("[WIFI] connected, IP address: " + WiFi.localIP().toString());
+        LOGGER_INFO(logger, "[WIFI] connected, IP address: " + WiFi.localIP().toString());
         return true;
     } else {
         return false;
@@ -680,9 +1374,9 @@ bool setupWiFi(int timeoutConfigAp, int timeoutConnection)
         });
     };
 
-    logger.log(F("[Wifi Setup]"));
+    LOGGER_INFO(logger, F("[Wifi Setup]"));
     if (tryToConnect(timeoutConnection)) {
-        logger.log(F("[Wifi Setup] direct connection, return"));
+        LOGGER_INFO(logger, F("[Wifi Setup] direct connection, return"));
         return true;
     }
 
@@ -694,7 +1388,7 @@ bool setupWiFi(int timeoutConfigAp, int timeoutConnection)
     } while (!tryWiFiReconnect);
     tryWiFiReconnect = false;
 
-    logger.log(F("[Wifi Setup] try wifi reconnect"));
+    LOGGER_INFO(logger, F("[Wifi Setup] try wifi reconnect"));
     callLoopList();
     resetConfigAp();
     resetDnsServer();
@@ -707,7 +1401,7 @@ bool setupSyslog()
     auto &config = p_var->config;
     auto &syslog = p_var->syslog;
     auto &syslogUdpClient = p_var->syslogUdpClient;
-    logger.log(F("[Syslog Setup]"));
+    LOGGER_INFO(logger, F("[Syslog Setup]"));
     String syslog_server;
     int syslog_port;
     config.getSyslogConfig(syslog_server, syslog_port);
@@ -727,61 +1421,65 @@ bool setupOTA()
         auto &ticker = p_var->ticker;
         auto &otaLogStorage = p_var->otaLogStorage;
         ticker.attach(0.2, tick);
-        logger.log("[OTA] start: " + String(ArduinoOTA.getCommand() == U_FLASH ? "sketch" : "filesystem"));
+        LOGGER_INFO(logger, "[OTA] start: " + String(ArduinoOTA.getCommand() == U_FLASH ? "sketch" : "filesystem"));
         otaLogStorage.reset();
+        Storage::flush(); // a filesystem update replaces the store
     });
     ArduinoOTA.onProgress([](unsigned int progress, unsigned int total) {
         auto &logger = p_var->logger;
-        logger.log("[OTA] progress: " + String(progress / (total / 100)));
+        LOGGER_INFO(logger, "[OTA] progress: " + String(progress / (total / 100)));
     });
     ArduinoOTA.onEnd([]() {
         auto &logger = p_var->logger;
         auto &ticker = p_var->ticker;
         auto &otaLogStorage = p_var->otaLogStorage;
         ticker.detach();
-        logger.log("[OTA] end");
+        LOGGER_INFO(logger, "[OTA] end");
 
         DynamicJsonBuffer jsonBuffer;
         JsonObject& rootObject = jsonBuffer.createObject();
         rootObject.set("ota", "success");
         otaLogStorage.writeJson(rootObject);
+        Storage::flush(); // the core reboots right after this callback
 
-        digitalWrite(pins_arr, LOW); // prevent to fast flicker by early power-off
+        logger.flushQueue();
+        digitalWrite(board::relays, &RelayConfig::offLevel); // prevent to fast flicker by early power-off
         delay(2000);
     });
     ArduinoOTA.onError([](ota_error_t error) {
         auto &logger = p_var->logger;
         auto &otaLogStorage = p_var->otaLogStorage;
-        logger.log("[OTA] error (code: " + String(error) + ")", Logger::ERROR);
+        LOGGER_ERROR(logger, "[OTA] error (code: " + String(error) + ")");
         DynamicJsonBuffer jsonBuffer;
         JsonObject& rootObject = jsonBuffer.createObject();
         switch (error) {
         case OTA_AUTH_ERROR:
-            logger.log(F("[OTA] Auth Failed"), Logger::ERROR);
+            LOGGER_ERROR(logger, F("[OTA] Auth Failed"));
             rootObject.set(F("ota"), F("Auth Failed"));
             break;
         case OTA_BEGIN_ERROR:
-            logger.log(F("[OTA] Begin Failed"), Logger::ERROR);
+            LOGGER_ERROR(logger, F("[OTA] Begin Failed"));
             rootObject.set(F("ota"), F("Begin Failed"));
             break;
         case OTA_CONNECT_ERROR:
-            logger.log(F("[OTA] Connect Failed"), Logger::ERROR);
+            LOGGER_ERROR(logger, F("[OTA] Connect Failed"));
             rootObject.set(F("ota"), F("Connect Failed"));
             break;
         case OTA_RECEIVE_ERROR:
-            logger.log(F("[OTA] Receive Failed"), Logger::ERROR);
+            LOGGER_ERROR(logger, F("[OTA] Receive Failed"));
             rootObject.set(F("ota"), F("Receive Failed"));
             break;
         case OTA_END_ERROR:
-            logger.log(F("[OTA] End Failed"), Logger::ERROR);
+            LOGGER_ERROR(logger, F("[OTA] End Failed"));
             rootObject.set(F("ota"), F("End Failed"));
             break;
         }
         otaLogStorage.writeJson(rootObject);
+        Storage::flush();
     });
     setLoopListCb([]() {
         ArduinoOTA.handle();
-    });
+    }, "ota", 20);
     return true;
 }
 
@@ -790,11 +1488,219 @@ void setupMDNS()
     auto &logger = p_var->logger;
     String id = MDNS_ID;
     id.toLowerCase();
-    logger.log("[mDNS] setup local dns: https://" + id + ".local/");
+    LOGGER_INFO(logger, "[mDNS] setup local dns: https://" + id + ".local/");
     MDNS.begin(id);
     MDNS.addService("http", "tcp", 80); // ota
     MDNS.addService("https", "tcp", 443);
-    setLoopListCb(serveMDNS);
+    setLoopListCb(serveMDNS, "mdns", 100, Scheduler::PRIORITY_LOW);
+}
+
+void drainLogQueue()
+{
+    auto &logger = p_var->logger;
+    logger.drainQueue(LOG_DRAIN_BUDGET_US);
+}
+
+void setupUdpControl()
+{
+#if UDP_CONTROL_PORT
+    auto &logger = p_var->logger;
+    auto &udpControlClient = p_var->udpControlClient;
+    auto &udpControl = p_var->udpControl;
+    LOGGER_INFO(logger, "[Setup UDP control] port: " + String(UDP_CONTROL_PORT));
+    udpControl.begin(ESP.random());
+    udpControlClient.begin(UDP_CONTROL_PORT);
+    setLoopListCb(serveUdpControl, "udp", 0, Scheduler::PRIORITY_HIGH);
+#endif
+}
+
+void serveUdpControl()
+{
+    auto &udpControlClient = p_var->udpControlClient;
+    auto &udpControl = p_var->udpControl;
+
+    int size = udpControlClient.parsePacket();
+    if (!size) {
+        return;
+    }
+
+    UdpControl::Frame request;
+    if (size != sizeof(request) || udpControlClient.read((uint8_t*)&request, sizeof(request)) != sizeof(request)) {
+        udpControlClient.flush();
+        return;
+    }
+
+    UdpControl::Status status = udpControl.verify(request);
+    if (status == UdpControl::STATUS_INVALID) {
+        return; // don't answer unauthenticated frames
+    }
+
+    if (status == UdpControl::STATUS_OK && request.code != UdpControl::OP_STATE) {
+        // same semantics as a batch /api/set
+        RelayOp ops[board::RELAY_COUNT];
+        size_t count = 0;
+        for (uint8_t i = 0; i < board::RELAY_COUNT; i++) {
+            if (request.mask & (1U << i)) {
+                ops[count].relay = i + 1;
+                ops[count].value = request.code == UdpControl::OP_TOGGLE ? RelayOp::TOGGLE
+                    : request.code == UdpControl::OP_ON                 ? RelayOp::ON
+                                                                        : RelayOp::OFF;
+                count++;
+            }
+        }
+        applyRelayOps(ops, count);
+    }
+
+    UdpControl::Frame ack;
+    udpControl.sign(ack, request, status, getRelayState());
+    udpControlClient.beginPacket(udpControlClient.remoteIP(), udpControlClient.remotePort());
+    udpControlClient.write((const uint8_t*)&ack, sizeof(ack));
+    udpControlClient.endPacket();
+}
+
+void onMqttMessage(char* topic, byte* payload, unsigned int length)
+{
+    auto &logger = p_var->logger;
+    auto &mqttState = p_var->mqttState;
+
+    // <prefix>/<device>/relay/<n>/set
+    String relayTopic = mqttState.topic + "/relay/";
+    if (strncmp(topic, relayTopic.c_str(), relayTopic.length())) {
+        return;
+    }
+    char* end;
+    long relay = strtol(topic + relayTopic.length(), &end, 10);
+    if (strcmp(end, "/set") || relay < 1 || relay > board::RELAY_COUNT) {
+        LOGGER_WARN(logger, "[MQTT] unknown topic: " + String(topic));
+        return;
+    }
+
+    String value;
+    value.concat((const char*)payload, length);
+    value.toLowerCase();
+    RelayOp op = { (uint8_t)relay, RelayOp::TOGGLE };
+    if (value == "on" || value == "1" || value == "true") {
+        op.value = RelayOp::ON;
+    } else if (value == "off" || value == "0" || value == "false") {
+        op.value = RelayOp::OFF;
+    } else if (value != "toggle") {
+        LOGGER_WARN(logger, "[MQTT] unknown command: " + value);
+        return;
+    }
+    applyRelayOps(&op, 1);
+
+    // always confirm a command, even if the relay already had the requested state
+    mqttState.dirty |= 1U << (relay - 1);
+}
+
+bool connectMqtt()
+{
+    auto &logger = p_var->logger;
+    auto &mqtt = p_var->mqtt;
+    auto &mqttState = p_var->mqttState;
+    LOGGER_INFO(logger, "[MQTT] connect to " + mqttState.host + ":" + String(mqttState.port));
+
+    mqtt.setServer(mqttState.host.c_str(), mqttState.port);
+    String status = mqttState.topic + "/status";
+    if (!mqtt.connect(deviceId.c_str(), status.c_str(), 0, true, "offline")) {
+        LOGGER_WARN(logger, "[MQTT] connect failed, state: " + String(mqtt.state()));
+        return false;
+    }
+
+    mqtt.publish(status.c_str(), "online", true);
+    mqtt.subscribe((mqttState.topic + "/relay/+/set").c_str());
+    LOGGER_INFO(logger, "[MQTT] connected");
+    return true;
+}
+
+void publishMqttTelemetry()
+{
+    auto &mqtt = p_var->mqtt;
+    auto &mqttState = p_var->mqttState;
+    StreamString payload;
+    JsonWriter json(payload);
+    json.beginObject();
+    json.set(F("uptime"), millis() / 1000);
+    json.set(F("boot_count"), bootCount);
+    json.set(F("free_heap"), ESP.getFreeHeap());
+    json.set(F("rssi"), WiFi.RSSI());
+    json.set(F("relays"), getRelayState());
+    json.endObject();
+    mqtt.publish((mqttState.topic + "/telemetry").c_str(), payload.c_str());
+}
+
+void setupMqtt()
+{
+    auto &logger = p_var->logger;
+    auto &mqtt = p_var->mqtt;
+    auto &mqttWifiClient = p_var->mqttWifiClient;
+    auto &mqttState = p_var->mqttState;
+    LOGGER_INFO(logger, F("[Setup MQTT]"));
+    mqttState.topic = MQTT_TOPIC_PREFIX + deviceId;
+    mqttState.topic.toLowerCase();
+    mqttState.backoffMs = 0;
+
+    // bound the time a connection attempt can block the loop
+    mqttWifiClient.setTimeout(MQTT_CONNECT_TIMEOUT_MS);
+    mqtt.setSocketTimeout((MQTT_CONNECT_TIMEOUT_MS + 999) / 1000);
+    mqtt.setCallback(onMqttMessage);
+
+    setLoopListCb(serveMqtt, "mqtt", 0, Scheduler::PRIORITY_NORMAL, []() {
+        return WiFi.isConnected();
+    }, MQTT_BUDGET_US);
+}
+
+void serveMqtt()
+{
+    auto &config = p_var->config;
+    auto &mqtt = p_var->mqtt;
+    auto &mqttState = p_var->mqttState;
+
+    const Config::ServerConfig& server = config.getData().mqtt;
+    if (server.ip != mqttState.host || server.port != mqttState.port) {
+        // the config changed, start over without delay
+        if (mqtt.connected()) {
+            mqtt.disconnect();
+        }
+        mqttState.host = server.ip;
+        mqttState.port = server.port;
+        mqttState.backoffMs = 0;
+    }
+    if (!mqttState.host.length()) {
+        return;
+    }
+
+    if (!mqtt.connected()) {
+        unsigned long timeNow = millis();
+        if (timeNow - mqttState.lastAttemptMs < mqttState.backoffMs) {
+            return;
+        }
+        mqttState.lastAttemptMs = timeNow;
+        if (!connectMqtt()) {
+            // exponential backoff
+            mqttState.backoffMs = mqttState.backoffMs ? min(2 * mqttState.backoffMs, (unsigned long)MQTT_BACKOFF_MAX_MS) : MQTT_BACKOFF_MIN_MS;
+            return;
+        }
+        mqttState.backoffMs = 0;
+        mqttState.dirty = (1U << board::RELAY_COUNT) - 1; // publish the complete state
+        mqttState.lastTelemetryMs = timeNow - MQTT_TELEMETRY_INTERVAL_MS;
+    }
+
+    mqtt.loop();
+
+    // retained relay state, one relay per iteration to keep the loop short
+    if (mqttState.dirty) {
+        uint8_t i = __builtin_ctz(mqttState.dirty);
+        String topic = mqttState.topic + "/relay/" + String(i + 1);
+        if (mqtt.publish(topic.c_str(), board::isOn(board::relays[i]) ? "on" : "off", true)) {
+            mqttState.dirty &= ~(1U << i);
+        }
+    }
+
+    if (millis() - mqttState.lastTelemetryMs >= MQTT_TELEMETRY_INTERVAL_MS) {
+        mqttState.lastTelemetryMs = millis();
+        publishMqttTelemetry();
+    }
 }
 
 void serveMDNS()
@@ -813,15 +1719,15 @@ void setup()
     // first things first ...
     // forces a closed relay,
     // this guarantees an equal working when a user turns the light on
-    pinMode(pins_arr, OUTPUT);
-    digitalWrite(pins_arr, HIGH);
+    pinMode(board::relays, OUTPUT);
+    digitalWrite(board::relays, &RelayConfig::powerOnLevel);
 
     // start serial session
     Serial.begin(115200);
     Serial.println("[setup] setup workspace");
     p_var = new GlobalVar();
     auto &logger = p_var->logger;
-    logger.log("[setup] initialize and close the relays done!");
+    LOGGER_INFO(logger, "[setup] initialize and close the relays done!");
 
     // if a crash occurs, then do not immediately try to restart,
     // otherwise the releys are flickering all the time
@@ -830,7 +1736,7 @@ void setup()
     case rst_reason::REASON_WDT_RST:
     case rst_reason::REASON_EXCEPTION_RST:
     case rst_reason::REASON_SOFT_WDT_RST:
-        logger.log("[setup] exceptional reset occurred: " + ESP.getResetReason() + ", I'm going to sleep ... ");
+        LOGGER_INFO(logger, "[setup] exceptional reset occurred: " + ESP.getResetReason() + ", I'm going to sleep ... ");
         while (true) {
             delay(1000);
         }
@@ -842,8 +1748,13 @@ void setup()
     // update boot count
     DynamicJsonBuffer jsonBuffer;
     JsonObject& jsonObjectRoot = p_var->bootTimeStorage.loadJson(jsonBuffer);
-    jsonObjectRoot.set("bootcount", 1 + (jsonObjectRoot["bootcount"] | 0));
+    bootCount = 1 + (jsonObjectRoot["bootcount"] | 0);
+    jsonObjectRoot.set("bootcount", bootCount);
     p_var->bootTimeStorage.writeJson(jsonObjectRoot);
+    Storage::flush(); // the loop may never start
+    setLoopListCb([]() {
+        Storage::serve(&p_var->logger);
+    }, "storage", 100, Scheduler::PRIORITY_LOW, nullptr, STORAGE_BUDGET_US);
 
     // register loggers
     logger.resetDefaultLogger();
@@ -852,7 +1763,7 @@ void setup()
             Serial.println(message);
         },
         Logger::DEBUG);
-    logger.log("[setup] serial log registered");
+    LOGGER_INFO(logger, "[setup] serial log registered");
     logger.registerLogger(
         [](const String& message) {
             if (p_var->syslog) {
@@ -860,15 +1771,17 @@ void setup()
             }
         },
         Logger::DEBUG);
-    logger.log("[setup] syslog log registered");
+    LOGGER_INFO(logger, "[setup] syslog log registered");
 
-    logger.log("[setup] starting Up ...");
-    logger.log("[setup] esp serial number: " + deviceId);
+    LOGGER_INFO(logger, "[setup] starting Up ...");
+    LOGGER_INFO(logger, "[setup] esp serial number: " + deviceId);
 
     system_update_cpu_freq(SYS_CPU_160MHZ);
+    // after the clock switch, cpu_freq_mhz is cached
+    p_var->systemInfo.begin(bootCount, deviceId.c_str(), board::NAME, board::RELAY_COUNT);
 
     // create a setup phase identification
-    logger.log("[setup] attach builtin led ticker");
+    LOGGER_INFO(logger, "[setup] attach builtin led ticker");
     pinMode(LED_BUILTIN, OUTPUT);
     p_var->ticker.attach(0.6, tick);
 
@@ -882,14 +1795,16 @@ void setup()
     if (!setupWiFi()) {
         // could not connect to wifi
         // for security reasons, stop also hosting config portal.
-        logger.log("[setup] wifi setup: could not connect during setup", Logger::ERROR);
-        logger.log("[setup] wifi setup: go into endless loop", Logger::WARN);
+        LOGGER_ERROR(logger, "[setup] wifi setup: could not connect during setup");
+        LOGGER_WARN(logger, "[setup] wifi setup: go into endless loop");
         while (true) {
             delay(1000);
         }
     }
 
     setupSyslog();
+    setupUdpControl();
+    setupMqtt();
 
     // keep LED on
     p_var->ticker.detach();
@@ -897,15 +1812,21 @@ void setup()
 
     setLoopListCb([]() {
         // keep WiFi active
-        if (!WiFi.isConnected()) {
-            reconnectWiFi(true);
-        }
+        reconnectWiFi(true);
+    }, "wifi", 5000, Scheduler::PRIORITY_LOW, []() {
+        return !WiFi.isConnected();
     });
 
     showSystemInfo(); // show it again because we're now connected to Syslog
     setupMDNS(); // do this setup again to ensure a properly working system
 
-    logger.log("[setup] Setup done! Entering loop mode ...");
+    // from now on, logging only appends to the queue, the loop pushes it to serial and syslog
+    logger.setQueued(true);
+    setLoopListCb(drainLogQueue, "log", 0, Scheduler::PRIORITY_LOW, []() {
+        return p_var->logger.getQueueLength() > 0;
+    }, LOG_BUDGET_US);
+
+    LOGGER_INFO(logger, "[setup] Setup done! Entering loop mode ...");
 }
 
 void loop()
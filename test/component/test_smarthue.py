@@ -3,16 +3,22 @@ import sys
 import json
 import logging
 import pytest
+import select
+import socket
+import threading
+from urllib.parse import urlparse
 
 repo_name = "SmartHue"
 sys.path.append("{}{}/".format(os.path.abspath(__file__).split(repo_name)[0], repo_name))
 from smartHuePy.helpers.helpers import *
+from smartHuePy.helpers.udpcontrol import UdpControl
 
 logging.basicConfig(filename='test.log', filemode='w', level=logging.DEBUG)
 devices_config_path = "%s/devices.json" % get_dir_path_of_this_repo()
 logging.info("config path: {}".format(devices_config_path))
 devices_config = load_json_path(devices_config_path)
 devices = devices_config["devices"]["test"]
+mqtt_broker = devices_config.get("mqtt")  # optional: {"ip": "...", "port": 1883}
 
 
 def check_for_reboot(device, boot_count=0, trigger=False):
@@ -52,6 +58,46 @@ def check_version_api(device):
     assert project_version.version_string in device_version["software"]["version"]
 
 
+def check_system_info_api(device):
+    system_info = device.get_system_info()
+    assert system_info, "could not load system info"
+
+    dynamic = device.get_system_info(fields="dynamic")
+    assert "free_heap" in dynamic and "uptime" in dynamic, "dynamic fields should be included"
+    assert "sketch_md5" not in dynamic and "boot_count" not in dynamic, "static fields should be left out"
+
+    selected = device.get_system_info(fields="sketch_md5,boot_count")
+    assert sorted(selected) == ["boot_count", "sketch_md5"]
+    assert selected["sketch_md5"] == system_info["sketch_md5"], "cached fields should not change"
+    assert selected["boot_count"] == system_info["boot_count"], "cached fields should not change"
+
+
+def check_state_api(device):
+    state = device.get_state()
+    assert state, "could not load the state"
+    etag = device.last_headers.get("ETag")
+    assert etag, "the state should have an ETag"
+    assert len(state["relays"]) >= 2
+    assert state["relays"][0] == device.get_relay(1)["value"]
+
+    assert device.get_state(etag) is True and device.last_status == 304, "an unchanged state should be a 304"
+
+    device.set_relay(1)  # toggle
+    changed = device.get_state(etag)
+    assert changed and changed is not True, "a relay change should change the ETag"
+    assert changed["relays"][0] != state["relays"][0]
+    assert changed["generation"] > state["generation"]
+    device.set_relay(1)
+
+
+def check_metrics_api(device):
+    metrics = device.get_metrics()
+    assert metrics, "could not load the metrics"
+    assert "\r" not in metrics, "the Prometheus text format only allows \\n line endings"
+    assert "# TYPE smarthue_free_heap_bytes gauge\n" in metrics
+    assert "smarthue_http_requests_total{" in metrics
+
+
 def check_relay_api(device, relay):
     device.set_relay(relay, False)
     assert not device.get_relay(relay)["value"], "relay should be turned off"
@@ -63,6 +109,110 @@ def check_relay_api(device, relay):
     assert device.get_relay(relay)["value"], "relay should be toggled"
 
 
+def check_relay_batch_api(device):
+    state = device.set_relays([{"relay": 1, "value": False}, {"relay": 2, "value": False}])
+    assert state == [{"relay": 1, "value": False}, {"relay": 2, "value": False}], "relays should be turned off"
+    state = device.set_relays([{"relay": 1}, {"relay": 2, "value": True}])
+    assert state == [{"relay": 1, "value": True}, {"relay": 2, "value": True}], "relays should be turned on"
+    state = device.set_relays([{"relay": 1, "op": "toggle"}, {"relay": 3, "value": True}])
+    assert not state, "a batch with an unknown relay should be rejected"
+    assert device.get_relay(1)["value"], "a rejected batch should not switch any relay"
+    assert not device.set_relays([{"relay": 1, "value": False}] * 128), "an oversized body should be rejected"
+    assert device.last_status == 413
+
+
+def check_cbor_api(device):
+    device.encoding = "cbor"
+    try:
+        system_info = device.get_system_info("free_heap")
+        assert system_info and "free_heap" in system_info, "could not load the systeminfo as cbor"
+        assert device.last_headers.get("Content-Type") == "application/cbor"
+        check_relay_api(device, 1)
+        check_relay_batch_api(device)
+        assert device.get_config()["version"], "could not load the config as cbor"
+    finally:
+        device.encoding = "json"
+
+
+def check_udp_retry(device, port=4210):
+    """
+    relay the udp control frames through a local proxy that drops the first ack,
+    the client resends the same frame and the relay should only be toggled once
+    """
+    host = urlparse(device.base_url).hostname
+    control = UdpControl(device.hostname, device.www_user, device.www_pass, port=port, host=host)
+    state = control.get_state()
+    assert state is not None, "could not read the relay state over udp"
+
+    client = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    client.bind(("127.0.0.1", 0))
+    upstream = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    upstream.connect(control.address)
+    counts = {"requests": 0, "acks": 0}
+    stop = threading.Event()
+
+    def proxy():
+        peer = None
+        while not stop.is_set():
+            readable, _, _ = select.select([client, upstream], [], [], 0.1)
+            if client in readable:
+                data, peer = client.recvfrom(64)
+                counts["requests"] += 1
+                upstream.send(data)
+            if upstream in readable:
+                data = upstream.recv(64)
+                counts["acks"] += 1
+                if counts["acks"] > 1:
+                    client.sendto(data, peer)
+
+    thread = threading.Thread(target=proxy)
+    thread.start()
+    lossy = UdpControl(device.hostname, device.www_user, device.www_pass, port=client.getsockname()[1],
+                       timeout=0.5, host="127.0.0.1")
+    lossy.nonce, lossy.seq = control.nonce, control.seq
+    try:
+        assert lossy.toggle_relays(0x01) == state ^ 0x01, "the resent toggle should report the toggled state"
+    finally:
+        stop.set()
+        thread.join()
+        lossy.close()
+        client.close()
+        upstream.close()
+    assert counts["requests"] == 2, "the toggle should be resent once after the lost ack"
+    assert control.get_state() == state ^ 0x01, "relay 1 should be toggled exactly once"
+    control.toggle_relays(0x01)
+    control.close()
+
+
+def check_mqtt(device, broker):
+    import paho.mqtt.client as mqtt
+
+    topic = "smarthue/%s" % device.hostname.lower()
+    messages = {}
+    client = mqtt.Client()
+    client.on_message = lambda client, userdata, message: messages.update({message.topic: message.payload.decode()})
+    client.connect(broker["ip"], broker.get("port", 1883))
+    client.subscribe("%s/#" % topic)
+    client.loop_start()
+    try:
+        assert device.post_config({"mqtt": {"ip": broker["ip"], "port": broker.get("port", 1883)}})
+
+        def online():
+            assert messages.get("%s/status" % topic) == "online", "device should connect to the broker"
+        wait_helper(online, "wait for mqtt connection", timeout=30, sleep=1)
+
+        for value in ["off", "on"]:
+            client.publish("%s/relay/1/set" % topic, value)
+
+            def state():
+                assert messages.get("%s/relay/1" % topic) == value, "relay state should be published"
+            wait_helper(state, "wait for mqtt relay state", timeout=10, sleep=0.5)
+            assert device.get_relay(1)["value"] == (value == "on"), "relay should follow the mqtt command"
+    finally:
+        client.loop_stop()
+        client.disconnect()
+
+
 class TestSmartHueApi:
     @classmethod
     def setup_class(cls):
@@ -108,9 +258,53 @@ class TestSmartHueApi:
         """
         check_version_api(device)
 
+    def test_system_info_api(self, device):
+        """
+        test the system info api and its fields filter
+        """
+        check_system_info_api(device)
+
+    def test_state_api(self, device):
+        """
+        test the state snapshot and its ETag
+        """
+        check_state_api(device)
+
+    def test_metrics_api(self, device):
+        """
+        test the prometheus metrics api
+        """
+        check_metrics_api(device)
+
     def test_relay_api(self, device):
         """
         test the relay set/get api
         """
         check_relay_api(device, 1)
         check_relay_api(device, 2)
+
+    def test_relay_batch_api(self, device):
+        """
+        test the relay batch set api
+        """
+        check_relay_batch_api(device)
+
+    def test_cbor_api(self, device):
+        """
+        test the relay, systeminfo and config api with cbor requests and responses
+        """
+        check_cbor_api(device)
+
+    def test_udp_retry(self, device):
+        """
+        test that a toggle over udp whose ack got lost is applied only once
+        """
+        check_udp_retry(device)
+
+    def test_mqtt(self, device):
+        """
+        test the mqtt relay commands and state against a local broker, see "mqtt" in devices.json
+        """
+        if not mqtt_broker:
+            pytest.skip("skipping test: no mqtt broker configured")
+        check_mqtt(device, mqtt_broker)
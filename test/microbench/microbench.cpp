@@ -0,0 +1,399 @@
+#include "CborReader/CborReader.h"
+#include "CborWriter/CborWriter.h"
+#include "ChunkedResponse/ChunkedResponse.h"
+#include "Config/Config.h"
+#include "JsonWriter/JsonWriter.h"
+#include "RequestBody/RequestBody.h"
+#include "Storage/Storage.h"
+#include "SystemInfo/SystemInfo.h"
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Logger.h>
+#include <NativeShim.h>
+#include <climits>
+#include <ctime>
+#include <malloc.h>
+
+/**
+ * Host microbenchmarks of the JSON, storage and logging hot paths.
+ *
+ * Every benchmark runs a fixed amount of iterations (after a warm up of a
+ * tenth of them), the heap is counted by wrapping malloc, so the numbers
+ * per op are exact and don't depend on the host load, only ns/op does.
+ *
+ * Arguments (after "--" on the command line of the program):
+ * --out <file>: result file, default microbench.json
+ * --baseline <file>: result file of an earlier run, a benchmark that
+ *     allocates more than in the baseline fails the run (exit code 1)
+ * --filter <text>: only run the benchmarks with this in their name
+ *
+ * ussage e.g.:
+ * pio run -e native-microbench
+ * .pio/build/native-microbench/program -- --baseline microbench.json --out new.json
+ */
+
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+extern "C" void __libc_free(void* ptr);
+
+static bool s_counting = false;
+static uint64_t s_allocs = 0;
+static uint64_t s_allocBytes = 0;
+
+static void countAlloc(size_t size)
+{
+    if (s_counting) {
+        s_allocs++;
+        s_allocBytes += size;
+    }
+}
+
+extern "C" void* malloc(size_t size)
+{
+    countAlloc(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    countAlloc(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    countAlloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void* ptr)
+{
+    __libc_free(ptr);
+}
+
+struct Result {
+    const char* name;
+    uint32_t iterations;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+#define MAX_RESULTS 32
+
+static Result s_results[MAX_RESULTS];
+static size_t s_resultCount = 0;
+static const char* s_filter = nullptr;
+
+static uint64_t monotonicNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+template <typename Op>
+static void bench(const char* name, uint32_t iterations, Op op)
+{
+    if ((s_filter && !strstr(name, s_filter)) || s_resultCount == MAX_RESULTS) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < iterations / 10; i++) {
+        op();
+    }
+
+    s_allocs = 0;
+    s_allocBytes = 0;
+    s_counting = true;
+    uint64_t startNs = monotonicNs();
+    for (uint32_t i = 0; i < iterations; i++) {
+        op();
+    }
+    uint64_t elapsedNs = monotonicNs() - startNs;
+    s_counting = false;
+
+    Result& result = s_results[s_resultCount++];
+    result.name = name;
+    result.iterations = iterations;
+    result.nsPerOp = (double)elapsedNs / iterations;
+    result.allocsPerOp = (double)s_allocs / iterations;
+    result.bytesPerOp = (double)s_allocBytes / iterations;
+    printf("%-32s %8u %12.1f ns/op %8.2f allocs/op %10.1f B/op\n",
+        name, iterations, result.nsPerOp, result.allocsPerOp, result.bytesPerOp);
+}
+
+/**
+ * Server that drops the response, ChunkedResponse only needs these.
+ */
+struct NullServer {
+    void setContentLength(size_t) { }
+    void send(int, const char*, const char*) { }
+    void sendContent(const char*) { }
+    void sendContent(const char* content, size_t length)
+    {
+        bytes += length;
+        (void)content;
+    }
+    size_t bytes = 0;
+};
+
+static void writeDocument(Storage& storage, const char* json)
+{
+    DynamicJsonBuffer jsonBuffer;
+    storage.writeJson(jsonBuffer.parseObject(json));
+    Storage::flush();
+}
+
+static void benchStorage()
+{
+    static const char* document = "{\"version\":\"1.2.0\",\"wifi\":{\"ssid\":\"smarthue\",\"pass\":\"8SuSfXjw2VRGEqKy\"},"
+                                  "\"mqtt\":{\"ip\":\"192.168.1.10\",\"port\":1883},\"syslog\":{\"ip\":\"192.168.1.10\",\"port\":514}}";
+
+    Storage storage("/bench/storage.json");
+    writeDocument(storage, document);
+    bench("storage/load_json", 20000, [&]() {
+        DynamicJsonBuffer jsonBuffer;
+        storage.loadJson(jsonBuffer);
+    });
+
+    Storage bootTimeStorage("/bench/boottime.json");
+    writeDocument(bootTimeStorage, "{\"bootcount\":12}");
+    bench("storage/load_json_bootcount", 20000, [&]() {
+        DynamicJsonBuffer jsonBuffer;
+        int bootCount = bootTimeStorage.loadJson(jsonBuffer)["bootcount"];
+        (void)bootCount;
+    });
+
+    // document of an older firmware, not migrated to the store yet
+    File file = LittleFS.open("/bench/legacy.json", "w");
+    file.print(document);
+    file.close();
+    bench("storage/load_json_file", 2000, []() {
+        DynamicJsonBuffer jsonBuffer;
+        Storage::loadJson(jsonBuffer, "/bench/legacy.json");
+    });
+}
+
+static void benchConfig()
+{
+    Config config;
+    config.setWifiConfig("smarthue", "8SuSfXjw2VRGEqKy");
+    config.setSyslogConfig("192.168.1.10", 514);
+    Storage::flush();
+
+    bench("config/get_wifi_config", 100000, [&]() {
+        String ssid;
+        String pass;
+        config.getWifiConfig(ssid, pass);
+    });
+    bench("config/get_syslog_config", 100000, [&]() {
+        String ip;
+        int port;
+        config.getSyslogConfig(ip, port);
+    });
+    bench("config/get_config_version", 100000, [&]() {
+        String version = config.getConfigVersion();
+    });
+    bench("config/reload", 20000, [&]() {
+        config.reload();
+    });
+}
+
+static void benchLogger()
+{
+    static size_t s_logged = 0;
+    Logger logger("SmartHue-5a3c1e");
+    logger.resetDefaultLogger();
+    logger.registerLogger([](const String& message) { s_logged += message.length(); }, Logger::DEBUG);
+
+    bench("logger/log", 50000, [&]() {
+        LOGGER_INFO(logger, "[Webserver] serve /api/systeminfo");
+    });
+    bench("logger/log_concat", 50000, [&]() {
+        LOGGER_INFO(logger, "[SetPin] relay: " + String(1) + ", value: " + String(true) + ", gpio: " + String(12));
+    });
+
+    logger.setThreshold(Logger::INFO);
+    bench("logger/log_filtered", 1000000, [&]() {
+        LOGGER_DEBUG(logger, "[SetPin] relay: " + String(1) + ", value: " + String(true) + ", gpio: " + String(12));
+    });
+    logger.setThreshold(Logger::DEBUG);
+
+#if LOGGER_QUEUE_SIZE > 0
+    logger.setQueued(true);
+    bench("logger/log_queued", 50000, [&]() {
+        LOGGER_INFO(logger, "[Webserver] serve /api/systeminfo");
+        logger.drainQueue(ULONG_MAX);
+    });
+    logger.setQueued(false);
+#endif
+}
+
+static void benchSystemInfo()
+{
+    SystemInfo systemInfo;
+    systemInfo.begin(12, "SmartHue-5a3c1e", "relay-2ch", 2);
+    SystemInfo::Runtime runtime;
+    runtime.loopFrequency = 21.5;
+    runtime.ipAddress = "192.168.1.42";
+    runtime.rssi = -61;
+
+    bench("systeminfo/serialize", 20000, [&]() {
+        NullServer server;
+        ChunkedResponse<NullServer> response(server);
+        response.begin(200, "application/json");
+        JsonWriter json(response);
+        systemInfo.printTo(json, runtime);
+        response.end();
+    });
+    bench("systeminfo/serialize_dynamic", 20000, [&]() {
+        NullServer server;
+        ChunkedResponse<NullServer> response(server);
+        response.begin(200, "application/json");
+        JsonWriter json(response);
+        systemInfo.printTo(json, runtime, "dynamic");
+        response.end();
+    });
+    bench("systeminfo/serialize_cbor", 20000, [&]() {
+        NullServer server;
+        ChunkedResponse<NullServer> response(server);
+        response.begin(200, CBOR_CONTENT_TYPE);
+        CborWriter cbor(response);
+        systemInfo.printTo(cbor, runtime);
+        response.end();
+    });
+}
+
+static void benchRequestBody()
+{
+    // [{"relay": 1, "value": true}, {"relay": 2}]
+    static const char* json = "[{\"relay\":1,\"value\":true},{\"relay\":2}]";
+    static const uint8_t cbor[] = { 0x82, 0xa2, 0x65, 'r', 'e', 'l', 'a', 'y', 0x01, 0x65, 'v', 'a', 'l', 'u', 'e', 0xf5,
+        0xa1, 0x65, 'r', 'e', 'l', 'a', 'y', 0x02 };
+
+    String body = json;
+    bench("request/parse_json", 50000, [&]() {
+        DynamicJsonBuffer jsonBuffer;
+        jsonBuffer.parse(body);
+    });
+    bench("request/parse_cbor", 50000, [&]() {
+        DynamicJsonBuffer jsonBuffer;
+        CborReader::parse(jsonBuffer, cbor, sizeof(cbor));
+    });
+
+    // /api/set: fixed body buffer and arena, parsed in place
+    static RequestBody<1024> requestBody;
+    bench("request/parse_json_in_place", 50000, [&]() {
+        StaticJsonBuffer<JSON_ARRAY_SIZE(2) + 2 * JSON_OBJECT_SIZE(2)> jsonBuffer;
+        requestBody.begin();
+        requestBody.write((const uint8_t*)body.c_str(), body.length());
+        requestBody.parseJson(jsonBuffer);
+    });
+    bench("request/parse_cbor_in_place", 50000, [&]() {
+        StaticJsonBuffer<JSON_ARRAY_SIZE(2) + 2 * JSON_OBJECT_SIZE(2)> jsonBuffer;
+        requestBody.begin();
+        requestBody.write(cbor, sizeof(cbor));
+        requestBody.parseCbor(jsonBuffer);
+    });
+}
+
+static bool writeResults(const char* path)
+{
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        return false;
+    }
+    fprintf(file, "{\n    \"benchmarks\": [\n");
+    for (size_t i = 0; i < s_resultCount; i++) {
+        const Result& result = s_results[i];
+        // one benchmark per line, readBaseline() depends on it
+        fprintf(file, "        {\"name\": \"%s\", \"iterations\": %u, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f, \"bytes_per_op\": %.1f}%s\n",
+            result.name, result.iterations, result.nsPerOp, result.allocsPerOp, result.bytesPerOp, i + 1 < s_resultCount ? "," : "");
+    }
+    fprintf(file, "    ]\n}\n");
+    fclose(file);
+    return true;
+}
+
+/**
+ * @return amount of benchmarks that allocate more than in the baseline, -1 if it can't be read
+ */
+static int compareBaseline(const char* path)
+{
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        return -1;
+    }
+
+    printf("\n%-32s %12s %12s %12s\n", "delta to baseline", "ns/op", "allocs/op", "B/op");
+    int regressions = 0;
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        char name[64];
+        Result baseline;
+        if (sscanf(line, " {\"name\": \"%63[^\"]\", \"iterations\": %u, \"ns_per_op\": %lf, \"allocs_per_op\": %lf, \"bytes_per_op\": %lf",
+                name, &baseline.iterations, &baseline.nsPerOp, &baseline.allocsPerOp, &baseline.bytesPerOp) != 5) {
+            continue;
+        }
+        for (size_t i = 0; i < s_resultCount; i++) {
+            const Result& result = s_results[i];
+            if (strcmp(result.name, name)) {
+                continue;
+            }
+            // the heap numbers are exact, the timing only an indication
+            bool regression = result.allocsPerOp > baseline.allocsPerOp + 0.005 || result.bytesPerOp > baseline.bytesPerOp + 0.05;
+            regressions += regression;
+            printf("%-32s %+11.1f%% %+12.2f %+12.1f%s\n", name,
+                baseline.nsPerOp > 0 ? 100.0 * (result.nsPerOp - baseline.nsPerOp) / baseline.nsPerOp : 0.0,
+                result.allocsPerOp - baseline.allocsPerOp, result.bytesPerOp - baseline.bytesPerOp,
+                regression ? "  REGRESSION" : "");
+        }
+    }
+    fclose(file);
+    return regressions;
+}
+
+void setup()
+{
+    const char* out = "microbench.json";
+    const char* baseline = nullptr;
+    for (int i = 0; i + 1 < native::options.sketchArgc; i += 2) {
+        const char* arg = native::options.sketchArgs[i];
+        const char* value = native::options.sketchArgs[i + 1];
+        if (!strcmp(arg, "--out")) {
+            out = value;
+        } else if (!strcmp(arg, "--baseline")) {
+            baseline = value;
+        } else if (!strcmp(arg, "--filter")) {
+            s_filter = value;
+        } else {
+            fprintf(stderr, "unknown argument: %s\n", arg);
+            exit(2);
+        }
+    }
+
+    LittleFS.begin();
+    printf("%-32s %8s\n", "benchmark", "iterations");
+    benchStorage();
+    benchConfig();
+    benchLogger();
+    benchSystemInfo();
+    benchRequestBody();
+
+    if (!writeResults(out)) {
+        exit(2);
+    }
+    int regressions = baseline ? compareBaseline(baseline) : 0;
+    if (regressions < 0) {
+        exit(2);
+    }
+    exit(regressions ? 1 : 0);
+}
+
+void loop()
+{
+}